@@ -0,0 +1,46 @@
+#!/bin/bash
+
+# End-to-end benchmark: each run writes one JSON report line (orders/s and per stage latency in ns)
+
+orders=100000
+workers=1
+scale=0
+runs=1
+extra=""
+
+usage() {
+    echo "USAGE: $0 [-n orders] [-w workers] [-x time-scale] [-m] [-t trace] [-r runs] [-o output] [-l launcher-args]"
+    exit 1
+}
+
+out=/dev/stdout
+while getopts "n:w:x:mt:r:o:l:" opt; do
+    case $opt in
+        n) orders=$OPTARG;;
+        w) workers=$OPTARG;;
+        x) scale=$OPTARG;;
+        m) extra="$extra -m";;
+        t) extra="$extra -t $OPTARG";;
+        r) runs=$OPTARG;;
+        o) out=$OPTARG;;
+        l) extra="$extra $OPTARG";;
+        *) usage;;
+    esac
+done
+
+if ! [ $runs -gt 0 ] 2>/dev/null; then
+    echo "Wrong number of runs (\"$runs\"). Aborting."
+    exit 1
+fi
+
+report=$(mktemp)
+for i in $(seq 1 $runs)
+do
+     if ! ./probSemSharedMemSmokers -n $orders -w $workers -x $scale $extra -b $report /dev/null 2>/dev/null; then
+         echo "Run $i failed. Aborting." >&2
+         rm -f $report
+         exit 1
+     fi
+     cat $report >> $out
+done
+rm -f $report
@@ -0,0 +1,32 @@
+#!/bin/bash
+
+# Locking benchmark: bench.sh runs with the sharded lock domains and with the global mutex (-G) for growing
+# numbers of workers per smoker, one JSON report line per run (the "locking" field tells them apart).
+
+orders=20000
+runs=3
+scale=0
+bargs=""
+workers="1 2 4 8 16"
+
+usage() {
+    echo "USAGE: $0 [-n orders] [-r runs] [-x time-scale] [-m] [-W \"workers list\"]"
+    exit 1
+}
+
+while getopts "n:r:x:mW:" opt; do
+    case $opt in
+        n) orders=$OPTARG;;
+        r) runs=$OPTARG;;
+        x) scale=$OPTARG;;
+        m) bargs="$bargs -m";;
+        W) workers=$OPTARG;;
+        *) usage;;
+    esac
+done
+
+cd "$(dirname "$0")"
+for w in $workers; do
+    ./bench.sh -n $orders -r $runs -x $scale -w $w $bargs || exit 1
+    ./bench.sh -n $orders -r $runs -x $scale -w $w $bargs -l "-G" || exit 1
+done
@@ -0,0 +1,46 @@
+#!/bin/bash
+
+# Placement benchmark: bench.sh runs once per placement, each JSON report line tagged with the placement label.
+# A placement is given as label="launcher options" (e.g. split="-a agent=node0 -a smoker=node1 -M 0 -L -e /dev/null");
+# without any, the process placement of the OS is compared with everything on node 0 and, on machines with
+# more than one node, with the entities split across nodes and with the shared region on a remote node.
+# The -L placements record the state transitions (and discard them), so that -L has buffers to bind.
+
+orders=100000
+runs=3
+bargs=""
+
+usage() {
+    echo "USAGE: $0 [-n orders] [-r runs] [-w workers] [-m] [label=\"launcher options\" ...]"
+    exit 1
+}
+
+while getopts "n:r:w:m" opt; do
+    case $opt in
+        n) orders=$OPTARG;;
+        r) runs=$OPTARG;;
+        w) bargs="$bargs -w $OPTARG";;
+        m) bargs="$bargs -m";;
+        *) usage;;
+    esac
+done
+shift $((OPTIND - 1))
+
+cd "$(dirname "$0")"
+if [ $# -eq 0 ]; then
+    nodes=$(ls -d /sys/devices/system/node/node[0-9]* 2>/dev/null | wc -l)
+    set -- "os=" "compact=-a agent=node0 -a watcher=node0 -a smoker=node0 -a matcher=node0 -M 0 -L -e /dev/null"
+    if [ $nodes -gt 1 ]; then
+        set -- "$@" "split=-a agent=node0 -a watcher=node0 -a matcher=node0 -a smoker=node1 -M 0 -L -e /dev/null" \
+                    "remote=-a agent=node0 -a watcher=node0 -a smoker=node0 -a matcher=node0 -M 1"
+    fi
+fi
+
+for p in "$@"; do
+    label=${p%%=*}
+    opts=${p#*=}
+    if [ "$label" = "$p" ]; then
+        usage
+    fi
+    ./bench.sh -n $orders -r $runs $bargs -l "$opts" | sed "s/^{/{\"placement\":\"$label\",/" || exit 1
+done
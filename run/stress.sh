@@ -0,0 +1,93 @@
+#!/bin/bash
+
+# Stress test: many simulations with seeded schedule perturbation run concurrently, each one in its own
+# directory and with its own IPC key. A run fails if the launcher fails, if its watchdog sees no progress
+# for half the timeout (deadlock), if it does not finish in time, if the log records are out of order (the
+# cigarettes go down from a line to the next) or if the final state, which the launcher writes last, is not
+# every entity closing with as many cigarettes as orders.
+# Failing seeds are printed together with the command that reproduces them.
+
+first=1
+count=1000
+jobs=$(nproc)
+limit=10
+orders=20
+workers=1
+extra=""
+
+usage() {
+    echo "USAGE: $0 [-s first-seed] [-c count] [-j jobs] [-T timeout-s] [-n orders] [-w workers] [-m]"
+    exit 1
+}
+
+while getopts "s:c:j:T:n:w:m" opt; do
+    case $opt in
+        s) first=$OPTARG;;
+        c) count=$OPTARG;;
+        j) jobs=$OPTARG;;
+        T) limit=$OPTARG;;
+        n) orders=$OPTARG;;
+        w) workers=$OPTARG;;
+        m) extra="$extra -m";;
+        *) usage;;
+    esac
+done
+
+for v in "$first" "$count" "$jobs" "$limit" "$workers"; do
+    if ! [ "$v" -gt 0 ] 2>/dev/null; then
+        echo "Wrong argument value (\"$v\"). Aborting."
+        exit 1
+    fi
+done
+
+bin=$(cd "$(dirname "$0")" && pwd)
+deadline=$(awk -v t=$limit 'BEGIN { print t / 2 }')
+export bin limit deadline orders workers extra
+
+# one run: prints nothing on success, a FAIL line otherwise
+runOne() {
+    local seed=$1 dir key rc reason cig bad
+    key=$(( 0x10000000 + seed % 0x10000000 ))
+    dir=$(mktemp -d) || return 1
+    for p in probSemSharedMemSmokers agent watcher smoker matcher; do
+        ln -s "$bin/$p" "$dir/$p"
+    done
+    cd "$dir"
+    timeout -k 1 $limit ./probSemSharedMemSmokers -k $key -p $seed -s $seed -x 0 -n $orders -w $workers $extra \
+            -d $deadline log > /dev/null 2> launcher.err
+    rc=$?
+    reason=""
+    if [ $rc -eq 124 ] || [ $rc -eq 137 ]; then
+        reason="not finished in ${limit}s (deadlock?)"
+        ipcs -s -i $(ipcs -s | awk -v k=$(printf "0x%08x" $key) '$1 == k { print $2 }') 2>/dev/null > semaphores
+    elif grep -q "^watchdog" launcher.err; then
+        reason="deadlock: $(sed -n 's/^  \(.*[^ ]\) *pid .* blocked on \(.*\)$/\1 on \2/p' launcher.err | paste -sd ',')"
+    elif [ $rc -ne 0 ]; then
+        reason="launcher exit status $rc: $(tail -1 launcher.err)"
+    else
+        bad=$(awk -v n=$((3 * workers)) '$1 ~ /^[0-9]+$/ { s = 0; for (i = NF - n + 1; i <= NF; i++) s += $i;
+                  if (s < last) { print NR; exit } last = s }' log)
+        cig=$(tail -1 log | awk -v n=$((3 * workers)) '{ s = 0; for (i = NF - n + 1; i <= NF; i++) s += $i; print s }')
+        if [ -n "$bad" ]; then
+            reason="log record $bad out of order"
+        elif ! tail -1 log | awk -v n=$((4 + 3 * workers)) '{ for (i = 1; i <= n; i++) if ($i != 3) exit 1 }'; then
+            reason="final state not closing: $(tail -1 log)"
+        elif [ "$cig" != "$orders" ]; then
+            reason="$cig cigarettes for $orders orders"
+        fi
+    fi
+    ipcrm -M $key -S $key 2>/dev/null
+    if [ -n "$reason" ]; then
+        echo "FAIL seed $seed: $reason (kept in $dir)"
+        echo "     reproduce: ./probSemSharedMemSmokers -p $seed -s $seed -x 0 -n $orders -w $workers$extra -d $deadline log"
+    else
+        cd / && rm -rf "$dir"
+    fi
+}
+export -f runOne
+
+out=$(seq $first $((first + count - 1)) | xargs -P $jobs -I{} bash -c 'runOne {}')
+nFail=$(echo -n "$out" | grep -c "^FAIL")
+[ -n "$out" ] && echo "$out"
+echo "$count runs, $nFail failed"
+[ $nFail -eq 0 ]
@@ -0,0 +1,56 @@
+#!/bin/bash
+
+# Transport benchmark: the same runs (orders, workers, time scale and seed) with shared memory and semaphores
+# and with the socket transport over Unix-domain and TCP loopback, one JSON report line per run, each one
+# tagged with its transport (shm, unix or tcp).
+
+orders=20000
+workers=1
+scale=0
+seed=1
+runs=1
+port=47000
+
+usage() {
+    echo "USAGE: $0 [-n orders] [-w workers] [-x time-scale] [-s seed] [-r runs] [-p tcp-port]"
+    exit 1
+}
+
+while getopts "n:w:x:s:r:p:" opt; do
+    case $opt in
+        n) orders=$OPTARG;;
+        w) workers=$OPTARG;;
+        x) scale=$OPTARG;;
+        s) seed=$OPTARG;;
+        r) runs=$OPTARG;;
+        p) port=$OPTARG;;
+        *) usage;;
+    esac
+done
+
+if ! [ $runs -gt 0 ] 2>/dev/null; then
+    echo "Wrong number of runs (\"$runs\"). Aborting."
+    exit 1
+fi
+
+cd "$(dirname "$0")"
+report=$(mktemp)
+args="-n $orders -w $workers -x $scale -s $seed -b $report"
+for i in $(seq 1 $runs)
+do
+    if ! ./probSemSharedMemSmokers $args /dev/null > /dev/null 2>&1; then
+        echo "Shared memory run $i failed. Aborting." >&2
+        rm -f $report
+        exit 1
+    fi
+    sed 's/^{/{"transport":"shm",/' $report
+    for addr in unix:smokers.sock tcp:127.0.0.1:$port; do
+        if ! ./coordinator -l $addr $args /dev/null > /dev/null 2>&1; then
+            echo "Run $i over $addr failed. Aborting." >&2
+            rm -f $report
+            exit 1
+        fi
+        cat $report
+    done
+done
+rm -f $report
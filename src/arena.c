@@ -0,0 +1,136 @@
+/**
+ *  \file arena.c (implementation file)
+ *
+ *  \brief Arena of named regions within a shared memory block.
+ *
+ *  The block begins with a table of regions, each one with a name, an offset from the beginning of the block
+ *  and a length. Regions are carved out of the block in sequence (bump allocation) and are never freed. Only
+ *  offsets are stored, so the arena is valid at whatever address each process maps the block.
+ *
+ *  Defined operations:
+ *     \li space taken by a region
+ *     \li initialization of the arena
+ *     \li allocation of a named region
+ *     \li look up of a region by name.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+
+#include "arena.h"
+
+/** \brief magic number of an initialized arena */
+#define ARENAMAGIC             0x4172656eu
+
+/**
+ *  \brief Space taken by a region, alignment padding included.
+ *
+ *  The size of a block is the size of the header (<tt>sizeof (ARENA)</tt>) plus the space of every region.
+ *
+ *  \param len length of the region (in bytes)
+ *  \param align alignment of the region (power of 2)
+ *
+ *  \return maximum number of bytes the region takes in the block
+ */
+size_t arenaSpace (size_t len, size_t align)
+{
+    if (align < CACHELINE) {
+        align = CACHELINE;
+    }
+    return len + align - 1;
+}
+
+/**
+ *  \brief Initialization of the arena of a block, without any region.
+ *
+ *  \param base pointer to the beginning of the block
+ *  \param size size of the block (in bytes)
+ */
+void arenaInit (void *base, size_t size)
+{
+    ARENA *a = base;
+
+    a->nRegions = 0;
+    a->size = size;
+    a->used = sizeof (ARENA);
+    a->magic = ARENAMAGIC;
+}
+
+/**
+ *  \brief Allocation of a named region.
+ *
+ *  The region begins at an offset multiple of <tt>align</tt> (at least CACHELINE). Since a block is mapped
+ *  at a page boundary, the region is aligned in any process for alignments up to the page size.
+ *  The function fails if the name is too long or already taken (\c EEXIST), if the table is full or the block
+ *  is exhausted (\c ENOMEM), or if the alignment is not a power of 2 (\c EINVAL).
+ *
+ *  \param base pointer to the beginning of the block
+ *  \param name region name
+ *  \param len length of the region (in bytes)
+ *  \param align alignment of the region (power of 2)
+ *
+ *  \return pointer to the region, upon success
+ *  \return \c NULL, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+void *arenaAlloc (void *base, const char *name, size_t len, size_t align)
+{
+    ARENA *a = base;
+    size_t off;                                                                      /* offset of the new region */
+
+    if ((align & (align - 1)) != 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (align < CACHELINE) {
+        align = CACHELINE;
+    }
+    if ((strlen (name) >= ARENANAME) || (arenaFind (base, name, NULL) != NULL)) {
+        errno = EEXIST;
+        return NULL;
+    }
+    off = (a->used + align - 1) & ~(align - 1);
+    if ((a->nRegions == ARENAREGIONS) || (off > a->size) || (len > a->size - off)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    strcpy (a->region[a->nRegions].name, name);
+    a->region[a->nRegions].off = off;
+    a->region[a->nRegions].len = len;
+    a->nRegions += 1;
+    a->used = off + len;
+
+    return (char *) base + off;
+}
+
+/**
+ *  \brief Look up of a region by name.
+ *
+ *  The function fails if the block holds no arena (\c EINVAL) or no region with that name (\c ENOENT).
+ *
+ *  \param base pointer to the beginning of the block
+ *  \param name region name
+ *  \param len pointer to the length of the region (in bytes), if not \c NULL
+ *
+ *  \return pointer to the region, upon success
+ *  \return \c NULL, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+void *arenaFind (const void *base, const char *name, size_t *len)
+{
+    const ARENA *a = base;
+
+    if (a->magic != ARENAMAGIC) {
+        errno = EINVAL;
+        return NULL;
+    }
+    for (unsigned int r = 0; r < a->nRegions; r++) {
+        if (strcmp (a->region[r].name, name) == 0) {
+            if (len != NULL) {
+                *len = a->region[r].len;
+            }
+            return (char *) base + a->region[r].off;
+        }
+    }
+    errno = ENOENT;
+    return NULL;
+}
@@ -0,0 +1,107 @@
+/**
+ *  \file arena.h (interface file)
+ *
+ *  \brief Arena of named regions within a shared memory block.
+ *
+ *  The block begins with a table of regions, each one with a name, an offset from the beginning of the block
+ *  and a length. Regions are carved out of the block in sequence (bump allocation) and are never freed. Only
+ *  offsets are stored, so the arena is valid at whatever address each process maps the block.
+ *
+ *  Defined operations:
+ *     \li space taken by a region
+ *     \li initialization of the arena
+ *     \li allocation of a named region
+ *     \li look up of a region by name.
+ */
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stddef.h>
+
+/** \brief maximum number of regions */
+#define ARENAREGIONS           16
+
+/** \brief maximum length of a region name (including the terminating null character) */
+#define ARENANAME              24
+
+/** \brief size of a cache line, the minimum alignment of every region */
+#define CACHELINE              64
+
+/** \brief description of a region */
+typedef struct {
+    /** \brief name */
+    char name[ARENANAME];
+    /** \brief offset from the beginning of the block */
+    size_t off;
+    /** \brief length (in bytes) */
+    size_t len;
+} ARENA_REGION;
+
+/** \brief arena header, at the beginning of the block */
+typedef struct {
+    /** \brief magic number, set when the arena is initialized */
+    unsigned int magic;
+    /** \brief number of regions */
+    unsigned int nRegions;
+    /** \brief size of the block (in bytes) */
+    size_t size;
+    /** \brief number of bytes already taken (header included) */
+    size_t used;
+    /** \brief region table */
+    ARENA_REGION region[ARENAREGIONS];
+} ARENA;
+
+/**
+ *  \brief Space taken by a region, alignment padding included.
+ *
+ *  The size of a block is the size of the header (<tt>sizeof (ARENA)</tt>) plus the space of every region.
+ *
+ *  \param len length of the region (in bytes)
+ *  \param align alignment of the region (power of 2)
+ *
+ *  \return maximum number of bytes the region takes in the block
+ */
+extern size_t arenaSpace (size_t len, size_t align);
+
+/**
+ *  \brief Initialization of the arena of a block, without any region.
+ *
+ *  \param base pointer to the beginning of the block
+ *  \param size size of the block (in bytes)
+ */
+extern void arenaInit (void *base, size_t size);
+
+/**
+ *  \brief Allocation of a named region.
+ *
+ *  The region begins at an offset multiple of <tt>align</tt> (at least CACHELINE). Since a block is mapped
+ *  at a page boundary, the region is aligned in any process for alignments up to the page size.
+ *  The function fails if the name is too long or already taken (\c EEXIST), if the table is full or the block
+ *  is exhausted (\c ENOMEM), or if the alignment is not a power of 2 (\c EINVAL).
+ *
+ *  \param base pointer to the beginning of the block
+ *  \param name region name
+ *  \param len length of the region (in bytes)
+ *  \param align alignment of the region (power of 2)
+ *
+ *  \return pointer to the region, upon success
+ *  \return \c NULL, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern void *arenaAlloc (void *base, const char *name, size_t len, size_t align);
+
+/**
+ *  \brief Look up of a region by name.
+ *
+ *  The function fails if the block holds no arena (\c EINVAL) or no region with that name (\c ENOENT).
+ *
+ *  \param base pointer to the beginning of the block
+ *  \param name region name
+ *  \param len pointer to the length of the region (in bytes), if not \c NULL
+ *
+ *  \return pointer to the region, upon success
+ *  \return \c NULL, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern void *arenaFind (const void *base, const char *name, size_t *len);
+
+#endif /* ARENA_H_ */
@@ -0,0 +1,151 @@
+/**
+ *  \file checkpoint.c (implementation file)
+ *
+ *  \brief Checkpoints of long simulations.
+ *
+ *  A checkpoint file is memory mapped and holds the configuration of the run it belongs to and two slots,
+ *  each one with the state at a quiescent point (every order completed and every entity waiting): the full
+ *  state of the problem, the number of orders completed, the states of the pseudo random generators and the
+ *  latency histograms. Slots are written alternately under a sequence counter, so a crash while saving
+ *  leaves the previous checkpoint intact. At a quiescent point every semaphore holds its initial value,
+ *  so a run is resumed from a fresh semaphore set.
+ *
+ *  Defined operations:
+ *     \li mapping of a checkpoint file
+ *     \li saving of a checkpoint
+ *     \li latest valid checkpoint
+ *     \li unmapping of a checkpoint file.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "checkpoint.h"
+#include "seqlock.h"
+
+/**
+ *  \brief Checking if a slot holds a complete checkpoint.
+ *
+ *  \param st pointer to the slot
+ *
+ *  \return true if the slot was written and is not being written
+ */
+static bool valid (const CKPT_STATE *st)
+{
+    unsigned int seq = __atomic_load_n (&st->seq, __ATOMIC_ACQUIRE);
+
+    return (seq != 0) && ((seq & 1) == 0);
+}
+
+/**
+ *  \brief Mapping of a checkpoint file.
+ *
+ *  A new file is created empty (no configuration and no valid slot); an existing file must have the size of
+ *  a checkpoint file (\c EINVAL otherwise).
+ *
+ *  \param name file name
+ *  \param create flag set when the file is created (or truncated)
+ *
+ *  \return pointer to the mapped file, upon success
+ *  \return \c NULL, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+CKPT *ckptMap (const char *name, bool create)
+{
+    int fd;                                                                                       /* file descriptor */
+    struct stat sb;
+    void *p;
+
+    if ((fd = open (name, create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0600)) == -1) {
+        return NULL;
+    }
+    if ((create && (ftruncate (fd, sizeof (CKPT)) == -1)) || (fstat (fd, &sb) == -1)) {
+        close (fd);
+        return NULL;
+    }
+    if (sb.st_size != sizeof (CKPT)) {
+        close (fd);
+        errno = EINVAL;
+        return NULL;
+    }
+    p = mmap (NULL, sizeof (CKPT), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);                                                              /* the mapping keeps the file open */
+
+    return (p == MAP_FAILED) ? NULL : p;
+}
+
+/**
+ *  \brief Saving of a checkpoint.
+ *
+ *  The slot not holding the latest checkpoint is overwritten. The file is written back after its sequence
+ *  counter is made odd, after its data is written and after the counter is made even again, so that after a
+ *  crash the disk never holds an even counter with partial data. Must be called at a quiescent point.
+ *
+ *  \param ck pointer to the mapped file
+ *  \param done number of orders completed
+ *  \param fSt pointer to the full state of the problem
+ *  \param rng slots of the pseudo random generators (NUMENTITIES)
+ *  \param latency latency histograms (NUMSTAGES)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int ckptSave (CKPT *ck, unsigned int done, const FULL_STAT *fSt, const RNG_SLOT rng[], const HISTO latency[])
+{
+    const CKPT_STATE *latest = ckptLatest (ck);
+    CKPT_STATE *st = (latest == &ck->slot[0]) ? &ck->slot[1] : &ck->slot[0];
+
+    seqWriteBegin (&st->seq);
+    if (msync (ck, sizeof (CKPT), MS_SYNC) == -1) {                            /* slot invalid on disk first */
+        return -1;
+    }
+    st->done = done;
+    st->fSt = *fSt;
+    for (unsigned int e = 0; e < NUMENTITIES; e++) {                     /* the file keeps the states packed */
+        st->rng[e] = rng[e].g;
+    }
+    memcpy (st->latency, latency, sizeof (st->latency));
+    if (msync (ck, sizeof (CKPT), MS_SYNC) == -1) {                           /* data on disk, still incomplete */
+        return -1;
+    }
+    seqWriteEnd (&st->seq);
+    return msync (ck, sizeof (CKPT), MS_SYNC);                                         /* then published */
+}
+
+/**
+ *  \brief Latest valid checkpoint.
+ *
+ *  \param ck pointer to the mapped file
+ *
+ *  \return pointer to the slot holding the latest checkpoint, or \c NULL if there is none
+ */
+const CKPT_STATE *ckptLatest (const CKPT *ck)
+{
+    bool v0 = valid (&ck->slot[0]),
+         v1 = valid (&ck->slot[1]);
+
+    if (v0 && v1) {
+        return (ck->slot[1].done > ck->slot[0].done) ? &ck->slot[1] : &ck->slot[0];
+    }
+    if (v0 || v1) {
+        return v0 ? &ck->slot[0] : &ck->slot[1];
+    }
+    return NULL;
+}
+
+/**
+ *  \brief Unmapping of a checkpoint file.
+ *
+ *  \param ck pointer to the mapped file
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int ckptUnmap (CKPT *ck)
+{
+    return munmap (ck, sizeof (CKPT));
+}
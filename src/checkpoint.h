@@ -0,0 +1,117 @@
+/**
+ *  \file checkpoint.h (interface file)
+ *
+ *  \brief Checkpoints of long simulations.
+ *
+ *  A checkpoint file is memory mapped and holds the configuration of the run it belongs to and two slots,
+ *  each one with the state at a quiescent point (every order completed and every entity waiting): the full
+ *  state of the problem, the number of orders completed, the states of the pseudo random generators and the
+ *  latency histograms. Slots are written alternately under a sequence counter, so a crash while saving
+ *  leaves the previous checkpoint intact. At a quiescent point every semaphore holds its initial value,
+ *  so a run is resumed from a fresh semaphore set.
+ *
+ *  Defined operations:
+ *     \li mapping of a checkpoint file
+ *     \li saving of a checkpoint
+ *     \li latest valid checkpoint
+ *     \li unmapping of a checkpoint file.
+ */
+
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <stdbool.h>
+
+#include "sharedDataSync.h"
+#include "prng.h"
+
+/** \brief default number of orders between checkpoints */
+#define CKPTEVERY              100000
+
+/** \brief state at a quiescent point */
+typedef struct {
+    /** \brief sequence counter (odd while the slot is being written, 0 if never written) */
+    unsigned int seq;
+    /** \brief number of orders completed */
+    unsigned int done;
+    /** \brief full state of the problem */
+    FULL_STAT fSt;
+    /** \brief states of the pseudo random generators (see ENT_* for the slots) */
+    PRNG rng[NUMENTITIES];
+    /** \brief latency of each benchmark stage (ns) */
+    HISTO latency[NUMSTAGES];
+} CKPT_STATE;
+
+/** \brief checkpoint file */
+typedef struct {
+    /** \brief magic number, set when the configuration is filled in */
+    unsigned int magic;
+    /** \brief number of orders of the run */
+    int nOrders;
+    /** \brief number of workers of each smoker */
+    int nWorkers;
+    /** \brief flag set when a single matcher process replaces the watchers */
+    bool matcher;
+    /** \brief seed of the pseudo random generators */
+    unsigned long long seed;
+    /** \brief name of the order trace replayed by the agent (empty string, if none) */
+    char trace[256];
+    /** \brief checkpoint slots */
+    CKPT_STATE slot[2];
+} CKPT;
+
+/** \brief magic number of a checkpoint file */
+#define CKPTMAGIC              0x436b7074u
+
+/**
+ *  \brief Mapping of a checkpoint file.
+ *
+ *  A new file is created empty (no configuration and no valid slot); an existing file must have the size of
+ *  a checkpoint file (\c EINVAL otherwise).
+ *
+ *  \param name file name
+ *  \param create flag set when the file is created (or truncated)
+ *
+ *  \return pointer to the mapped file, upon success
+ *  \return \c NULL, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern CKPT *ckptMap (const char *name, bool create);
+
+/**
+ *  \brief Saving of a checkpoint.
+ *
+ *  The slot not holding the latest checkpoint is overwritten. The file is written back after its sequence
+ *  counter is made odd, after its data is written and after the counter is made even again, so that after a
+ *  crash the disk never holds an even counter with partial data. Must be called at a quiescent point.
+ *
+ *  \param ck pointer to the mapped file
+ *  \param done number of orders completed
+ *  \param fSt pointer to the full state of the problem
+ *  \param rng slots of the pseudo random generators (NUMENTITIES)
+ *  \param latency latency histograms (NUMSTAGES)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int ckptSave (CKPT *ck, unsigned int done, const FULL_STAT *fSt, const RNG_SLOT rng[], const HISTO latency[]);
+
+/**
+ *  \brief Latest valid checkpoint.
+ *
+ *  \param ck pointer to the mapped file
+ *
+ *  \return pointer to the slot holding the latest checkpoint, or \c NULL if there is none
+ */
+extern const CKPT_STATE *ckptLatest (const CKPT *ck);
+
+/**
+ *  \brief Unmapping of a checkpoint file.
+ *
+ *  \param ck pointer to the mapped file
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int ckptUnmap (CKPT *ck);
+
+#endif /* CHECKPOINT_H_ */
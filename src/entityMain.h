@@ -0,0 +1,44 @@
+/**
+ *  \file entityMain.h (interface file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  Entry points of the intervening entities and of the launcher.
+ *
+ *  Each program is written as an entry point with the signature of <tt>main</tt>. The stand-alone
+ *  executables (agent, watcher, smoker, matcher and the launcher) have a <tt>main</tt> that just calls it;
+ *  the multi-call binary, built with MULTICALL defined, links all of them and dispatches on the name it
+ *  was invoked with (<tt>argv[0]</tt>) or on its first argument.
+ */
+
+#ifndef ENTITYMAIN_H_
+#define ENTITYMAIN_H_
+
+/** \brief entry point of a program */
+typedef int (*ENTRY) (int argc, char *argv[]);
+
+/** \brief entry point of the agent */
+extern int agentMain (int argc, char *argv[]);
+
+/** \brief entry point of the watcher */
+extern int watcherMain (int argc, char *argv[]);
+
+/** \brief entry point of the smoker */
+extern int smokerMain (int argc, char *argv[]);
+
+/** \brief entry point of the matcher */
+extern int matcherMain (int argc, char *argv[]);
+
+/** \brief entry point of the launcher */
+extern int launcherMain (int argc, char *argv[]);
+
+/**
+ *  \brief Finding the entry point of a program of the multi-call binary.
+ *
+ *  \param name program name (a path is allowed, only its last component is used)
+ *
+ *  \return entry point, or NULL if there is no program with that name
+ */
+extern ENTRY entryFind (const char *name);
+
+#endif /* ENTITYMAIN_H_ */
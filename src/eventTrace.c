@@ -0,0 +1,151 @@
+/**
+ *  \file eventTrace.c (implementation file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  \brief Timeline of the states of the intervening entities.
+ *
+ *  Every state transition of an entity is recorded, with a timestamp, in the event buffer of that entity, in a
+ *  region of the shared block that only exists when recording is enabled. Each transition ends the previous
+ *  state and begins the new one.
+ *  At the end of the simulation, the timelines are exported in the Chrome Trace Event format (JSON),
+ *  which is understood by chrome://tracing and Perfetto.
+ *
+ *  Defined operations:
+ *     \li recording of a state transition of an entity
+ *     \li exporting the timelines of all entities
+ *     \li naming of the states of an entity.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "sharedDataSync.h"
+#include "stats.h"
+#include "eventTrace.h"
+
+/** \brief names of the agent states */
+static const char *agentName[] = { "?", "PREPARING", "WAITING_CIG", "CLOSING_A" };
+/** \brief names of the watcher states */
+static const char *watcherName[] = { "WAITING_ING", "UPDATING", "INFORMING", "CLOSING_W" };
+/** \brief names of the smoker states */
+static const char *smokerName[] = { "WAITING_2ING", "ROLLING", "SMOKING", "CLOSING_S" };
+
+/* internal functions */
+
+static void threadName (FILE *fic, SHARED_DATA *sh, unsigned int entity)
+{
+    unsigned int w;
+
+    fprintf (fic, ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"", entity);
+    if (entity == ENT_AGENT)
+       fprintf (fic, "agent");
+    else if (entity < ENT_SMOKER (0))
+            fprintf (fic, "watcher %u", entity - ENT_WATCHER (0));
+            else { w = entity - ENT_SMOKER (0);
+                   fprintf (fic, "smoker %u.%u", w / sh->fSt.nWorkers, w % sh->fSt.nWorkers);
+                 }
+    fprintf (fic, "\"}}");
+}
+
+/* external functions */
+
+/**
+ *  \brief Recording of a state transition of an entity.
+ *
+ *  Nothing is done if event recording was not enabled by the launcher.
+ *  Only the latest EVENTCAP transitions of each entity are kept.
+ *
+ *  \param ev state transition buffers of the factory (\c NULL, if transitions are not recorded)
+ *  \param entity entity slot (see ENT_* in sharedDataSync.h)
+ *  \param state new state of the entity
+ */
+void evRecord (EVENT_BUF ev[], unsigned int entity, unsigned int state)
+{
+    EVENT_BUF *b;
+    EVENT *e;
+
+    if (ev == NULL)
+       return;
+    b = &ev[entity];
+    e = &b->ev[b->n % EVENTCAP];
+    e->ts = nowNs ();
+    e->state = state;
+    b->n += 1;
+}
+
+/**
+ *  \brief Exporting the timelines of all entities in the Chrome Trace Event format.
+ *
+ *  Each state becomes a complete event of the thread of its entity; the last state of each entity
+ *  lasts until the latest recorded transition of the whole simulation.
+ *
+ *  \param nFile name of the JSON file
+ *  \param sh pointer to shared memory region
+ *  \param ev state transition buffers of the factory
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int evExport (char nFile[], SHARED_DATA *sh, EVENT_BUF ev[])
+{
+    FILE *fic;                                                                                      /* file descriptor */
+    unsigned int nEnt = ENTSLOTS (sh->fSt.nWorkers);                              /* number of entity slots in use */
+    unsigned long long t0 = ~0ull, tEnd = 0;                                       /* first and last recorded times */
+    unsigned int ent, i, first;
+    EVENT_BUF *b;
+    EVENT *e, *next;
+
+    for (ent = 0; ent < nEnt; ent++) {
+        b = &ev[ent];
+        if (b->n == 0)
+           continue;
+        first = (b->n > EVENTCAP) ? b->n - EVENTCAP : 0;
+        if (b->ev[first % EVENTCAP].ts < t0)
+           t0 = b->ev[first % EVENTCAP].ts;
+        if (b->ev[(b->n - 1) % EVENTCAP].ts > tEnd)
+           tEnd = b->ev[(b->n - 1) % EVENTCAP].ts;
+    }
+
+    if ((fic = fopen (nFile, "w")) == NULL)
+       return -1;
+
+    fprintf (fic, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf (fic, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":0,\"args\":{\"name\":\"smokers\"}}");
+    for (ent = 0; ent < nEnt; ent++) {
+        b = &ev[ent];
+        threadName (fic, sh, ent);
+        first = (b->n > EVENTCAP) ? b->n - EVENTCAP : 0;
+        for (i = first; i < b->n; i++) {
+            e = &b->ev[i % EVENTCAP];
+            next = (i + 1 < b->n) ? &b->ev[(i + 1) % EVENTCAP] : NULL;
+            fprintf (fic, ",\n{\"ph\":\"X\",\"name\":\"%s\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                     evStateName (ent, e->state), ent, (e->ts - t0) / 1e3,
+                     (((next != NULL) ? next->ts : tEnd) - e->ts) / 1e3);
+        }
+    }
+    fprintf (fic, "\n]}\n");
+
+    return fclose (fic);
+}
+
+/**
+ *  \brief Naming of the states of an entity.
+ *
+ *  \param entity entity slot (see ENT_* in sharedDataSync.h)
+ *  \param state state of the entity
+ *
+ *  \return name of the state, as defined in probConst.h
+ */
+const char *evStateName (unsigned int entity, unsigned int state)
+{
+    if (state > 3)
+       return "?";
+    if (entity == ENT_AGENT)
+       return agentName[state];
+    if (entity < ENT_SMOKER (0))
+       return watcherName[state];
+    return smokerName[state];
+}
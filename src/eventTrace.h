@@ -0,0 +1,62 @@
+/**
+ *  \file eventTrace.h (interface file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  \brief Timeline of the states of the intervening entities.
+ *
+ *  Every state transition of an entity is recorded, with a timestamp, in the event buffer of that entity, in a
+ *  region of the shared block that only exists when recording is enabled. Each transition ends the previous
+ *  state and begins the new one.
+ *  At the end of the simulation, the timelines are exported in the Chrome Trace Event format (JSON),
+ *  which is understood by chrome://tracing and Perfetto.
+ *
+ *  Defined operations:
+ *     \li recording of a state transition of an entity
+ *     \li exporting the timelines of all entities
+ *     \li naming of the states of an entity.
+ */
+
+#ifndef EVENTTRACE_H_
+#define EVENTTRACE_H_
+
+#include "sharedDataSync.h"
+
+/**
+ *  \brief Recording of a state transition of an entity.
+ *
+ *  Nothing is done if event recording was not enabled by the launcher.
+ *  Only the latest EVENTCAP transitions of each entity are kept.
+ *
+ *  \param ev state transition buffers of the factory (\c NULL, if transitions are not recorded)
+ *  \param entity entity slot (see ENT_* in sharedDataSync.h)
+ *  \param state new state of the entity
+ */
+extern void evRecord (EVENT_BUF ev[], unsigned int entity, unsigned int state);
+
+/**
+ *  \brief Exporting the timelines of all entities in the Chrome Trace Event format.
+ *
+ *  Each state becomes a complete event of the thread of its entity; the last state of each entity
+ *  lasts until the latest recorded transition of the whole simulation.
+ *
+ *  \param nFile name of the JSON file
+ *  \param sh pointer to shared memory region
+ *  \param ev state transition buffers of the factory
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int evExport (char nFile[], SHARED_DATA *sh, EVENT_BUF ev[]);
+
+/**
+ *  \brief Naming of the states of an entity.
+ *
+ *  \param entity entity slot (see ENT_* in sharedDataSync.h)
+ *  \param state state of the entity
+ *
+ *  \return name of the state, as defined in probConst.h
+ */
+extern const char *evStateName (unsigned int entity, unsigned int state);
+
+#endif /* EVENTTRACE_H_ */
@@ -0,0 +1,110 @@
+/**
+ *  \file genTrace.c (implementation file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  Generator of binary order traces to be replayed by the agent.
+ *
+ *  Upon execution, the following parameters are accepted:
+ *    \li <tt>-n orders</tt>: number of orders (default NUMORDERS)
+ *    \li <tt>-z skew</tt>: Zipf exponent of the popularity of the recipes (default 0, uniform);
+ *        recipe 0 is the hottest one
+ *    \li <tt>-d</tt>: the rolling and smoking durations are also generated
+ *    \li <tt>-s seed</tt>: seed of the pseudo random generator (default 1)
+ *    \li name of the trace file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "probConst.h"
+#include "trace.h"
+#include "prng.h"
+
+/**
+ *  \brief Main program.
+ *
+ *  Its role is writing a trace with the requested number of orders and popularity of recipes.
+ */
+int main (int argc, char *argv[])
+{
+    unsigned long long nOrders = NUMORDERS;                                                    /* number of orders */
+    unsigned long long seed = 1;                                                   /* seed of the random generator */
+    double skew = 0.0;                                                        /* Zipf exponent of recipes popularity */
+    uint16_t flags = 0;                                                                               /* trace flags */
+    double cumul[NUMSMOKERS];                                           /* cumulative popularity of the recipes */
+    char *tinp;                                                                     /* numerical parameters test flag */
+    TRACE t;                                                                                         /* mapped trace */
+    PRNG rng;                                                                                    /* random generator */
+    int opt, r;
+
+    while ((opt = getopt (argc, argv, "n:z:ds:")) != -1) {
+        switch (opt) {
+            case 'n': nOrders = strtoull (optarg, &tinp, 0);
+                      if ((*tinp != '\0') || (nOrders == 0) || (nOrders > INT32_MAX)) {
+                          fprintf (stderr, "Number of orders must be between 1 and %d!\n", INT32_MAX);
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'z': skew = strtod (optarg, &tinp);
+                      if ((*tinp != '\0') || (skew < 0.0)) {
+                          fprintf (stderr, "Skew must be a non negative real!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'd': flags |= TRACEDURATIONS;
+                      break;
+            case 's': seed = strtoull (optarg, &tinp, 0);
+                      if (*tinp != '\0') {
+                          fprintf (stderr, "Seed must be an unsigned integer!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            default:  optind = argc + 1;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf (stderr, "Usage: %s [-n orders] [-z skew] [-d] [-s seed] tracefile\n", argv[0]);
+        exit (EXIT_FAILURE);
+    }
+
+    /* popularity of the recipes (the recipe of smoker r lacks ingredient r) */
+    for (r = 0; r < NUMSMOKERS; r++) {
+        cumul[r] = pow (r + 1.0, -skew) + ((r > 0) ? cumul[r-1] : 0.0);
+    }
+    for (r = 0; r < NUMSMOKERS; r++) {
+        cumul[r] /= cumul[NUMSMOKERS-1];
+    }
+
+    if (traceCreate (argv[optind], nOrders, flags, &t) == -1) {
+        perror ("error on creating the trace file");
+        exit (EXIT_FAILURE);
+    }
+    prngSeed (&rng, seed, 0);
+
+    for (uint64_t i = 0; i < nOrders; i++) {
+        uint8_t *ing = t.rec + i * t.stride;
+        double u = prngUniform (&rng);
+        unsigned int swap = prngBelow (&rng, 2);
+
+        for (r = 0; (r < NUMSMOKERS - 1) && (u > cumul[r]); r++);
+        ing[swap]     = (uint8_t) ((r + 1) % NUMINGREDIENTS);
+        ing[1 - swap] = (uint8_t) ((r + 2) % NUMINGREDIENTS);
+
+        if (flags & TRACEDURATIONS) {
+            TRACE_RECORD *rec = (TRACE_RECORD *) ing;
+            rec->rolling = (float) (100.0 + 30.0 * prngNormal (&rng));
+            rec->smoking = (float) (100.0 + 30.0 * prngNormal (&rng));
+        }
+    }
+
+    if (traceClose (&t) == -1) {
+        perror ("error on closing the trace file");
+        exit (EXIT_FAILURE);
+    }
+
+    return EXIT_SUCCESS;
+}
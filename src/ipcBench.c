@@ -0,0 +1,309 @@
+/**
+ *  \file ipcBench.c (implementation file)
+ *
+ *  \brief Microbenchmarks of the IPC primitives.
+ *
+ *  Measured operations (each result is written as a JSON line, in ns per operation):
+ *    \li <em>down</em> + <em>up</em> round trip of an uncontended semaphore
+ *    \li ping-pong between two processes through two semaphores (one round trip per operation)
+ *    \li <em>down</em> + <em>up</em> of the MUTEX semaphore contended by N processes
+ *    \li connection to a semaphore set (semConnect)
+ *    \li connection to and mapping of a shared memory block (shmemConnect + shmemAttach)
+ *    \li saving of the full state into a file and onto stdout (saveState).
+ *
+ *  Upon execution, the following parameters are accepted:
+ *    \li <tt>-n iterations</tt>: number of operations of each benchmark (default 100000)
+ *    \li <tt>-p processes</tt>: number of processes contending for the mutex (default 4)
+ *    \li <tt>-k key</tt>: access key of the semaphore set and the shared memory blocks (default pid based).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "logging.h"
+#include "sharedDataSync.h"
+#include "semaphore.h"
+#include "sharedMemory.h"
+#include "stats.h"
+
+/** \brief number of semaphores used: MUTEX and the two ping-pong semaphores */
+#define  NSEMS          3
+/** \brief ping semaphore */
+#define  PING           2
+/** \brief pong semaphore */
+#define  PONG           3
+
+/** \brief number of operations of each benchmark */
+static unsigned int nIter = 100000;
+
+/** \brief semaphore set access identifier (-1 if none) */
+static int semgid = -1;
+
+/** \brief shared memory access identifier of the block in use (-1 if none) */
+static int shmid = -1;
+
+/** \brief process that owns the semaphore set and the shared memory blocks */
+static pid_t owner;
+
+/** \brief access key */
+static int key;
+
+/* internal functions */
+
+static void report (const char *name, int procs, const HISTO *h)
+{
+    printf ("{\"bench\":\"%s\",\"procs\":%d,\"ns_per_op\":%.1f,\"latency_ns\":", name, procs, histoMean (h));
+    histoPrintJson (stdout, h);
+    printf ("}\n");
+    fflush (stdout);
+}
+
+static void fail (const char *msg)
+{
+    perror (msg);
+    if (getpid () == owner) {                                  /* the forked processes leave them to the owner */
+       if (shmid != -1)
+          shmemDestroy (shmid);
+       if (semgid != -1)
+          semDestroy (semgid);
+    }
+    exit (EXIT_FAILURE);
+}
+
+static void semUncontended (HISTO *h)
+{
+    uint64_t t;
+
+    for (unsigned int i = 0; i < nIter; i++) {
+        t = nowNs ();
+        if ((semDown (semgid, MUTEX) == -1) || (semUp (semgid, MUTEX) == -1))
+           fail ("error on the down/up operations");
+        histoAdd (h, nowNs () - t);
+    }
+}
+
+static void semPingPong (HISTO *h)
+{
+    uint64_t t;
+    pid_t pid;
+
+    if ((pid = fork ()) < 0)
+       fail ("error on the fork operation");
+    if (pid == 0) {
+       for (unsigned int i = 0; i < nIter; i++) {
+           if ((semDown (semgid, PING) == -1) || (semUp (semgid, PONG) == -1))
+              fail ("error on the ping-pong operations");
+       }
+       exit (EXIT_SUCCESS);
+    }
+    for (unsigned int i = 0; i < nIter; i++) {
+        t = nowNs ();
+        if ((semUp (semgid, PING) == -1) || (semDown (semgid, PONG) == -1))
+           fail ("error on the ping-pong operations");
+        histoAdd (h, nowNs () - t);
+    }
+    waitpid (pid, NULL, 0);
+}
+
+static void semContended (HISTO *h, int nProcs)
+{
+    HISTO *res;                                                        /* one histogram per process, shared */
+    uint64_t t;
+
+    if ((shmid = shmemCreate (key + 1, nProcs * sizeof (HISTO))) == -1)
+       fail ("error on creating the shared memory region");
+    if (shmemAttach (shmid, (void **) &res) == -1)
+       fail ("error on mapping the shared region");
+
+    for (int p = 0; p < nProcs; p++) {
+        pid_t pid = fork ();
+        if (pid < 0)
+           fail ("error on the fork operation");
+        if (pid == 0) {
+           for (unsigned int i = 0; i < nIter / nProcs; i++) {
+               t = nowNs ();
+               if ((semDown (semgid, MUTEX) == -1) || (semUp (semgid, MUTEX) == -1))
+                  fail ("error on the down/up operations");
+               histoAdd (&res[p], nowNs () - t);
+           }
+           exit (EXIT_SUCCESS);
+        }
+    }
+    for (int p = 0; p < nProcs; p++) {
+        wait (NULL);
+    }
+    for (int p = 0; p < nProcs; p++) {
+        histoMerge (h, &res[p]);
+    }
+
+    shmemDettach (res);
+    shmemDestroy (shmid);
+    shmid = -1;
+}
+
+static void semConnectCost (HISTO *h)
+{
+    uint64_t t;
+
+    for (unsigned int i = 0; i < nIter; i++) {
+        t = nowNs ();
+        if (semConnect (key) == -1)
+           fail ("error on connecting to the semaphore set");
+        histoAdd (h, nowNs () - t);
+    }
+}
+
+static void shmemConnectCost (HISTO *h)
+{
+    void *add;
+    uint64_t t;
+
+    if ((shmid = shmemCreate (key, sizeof (SHARED_DATA))) == -1)
+       fail ("error on creating the shared memory region");
+    for (unsigned int i = 0; i < nIter; i++) {
+        t = nowNs ();
+        if ((shmemConnect (key) == -1) || (shmemAttach (shmid, &add) == -1))
+           fail ("error on connecting to the shared memory region");
+        histoAdd (h, nowNs () - t);
+        shmemDettach (add);
+    }
+    shmemDestroy (shmid);
+    shmid = -1;
+}
+
+static int discard (int fd)
+{
+    int saved, null;
+
+    if (((saved = dup (fd)) == -1) || ((null = open ("/dev/null", O_WRONLY)) == -1) || (dup2 (null, fd) == -1))
+       fail ("error on redirecting output");
+    close (null);
+    return saved;
+}
+
+static void restore (int fd, int saved)
+{
+    dup2 (saved, fd);
+    close (saved);
+}
+
+static void saveStateCost (HISTO *h, char nFic[])
+{
+    FULL_STAT fSt;
+    uint64_t t;
+    int err, out = -1;
+
+    fflush (stdout);
+    err = discard (STDERR_FILENO);                              /* opening messages go to the error file */
+    if ((nFic == NULL) || (nFic[0] == '\0'))
+       out = discard (STDOUT_FILENO);                                          /* stdout target: lines are discarded */
+
+    memset (&fSt, 0, sizeof (fSt));
+    fSt.nIngredients = NUMINGREDIENTS;
+    fSt.nSmokers = NUMSMOKERS;
+    fSt.nWorkers = 1;
+    fSt.nOrders = NUMORDERS;
+    for (unsigned int i = 0; i < nIter; i++) {
+        t = nowNs ();
+        saveState (nFic, &fSt);
+        histoAdd (h, nowNs () - t);
+    }
+
+    fflush (stdout);
+    if (out != -1)
+       restore (STDOUT_FILENO, out);
+    restore (STDERR_FILENO, err);
+}
+
+/**
+ *  \brief Main program.
+ *
+ *  Its role is running every microbenchmark and reporting its results.
+ */
+int main (int argc, char *argv[])
+{
+    static HISTO h;                                                                             /* results histogram */
+    char nFic[] = "/tmp/ipcBench_XXXXXX";                                               /* file target of saveState */
+    int nProcs = 4;                                                              /* number of contending processes */
+    int opt, fd;
+    char *tinp;
+
+    key = 0x5b000000 | (getpid () & 0xffffff);
+    while ((opt = getopt (argc, argv, "n:p:k:")) != -1) {
+        switch (opt) {
+            case 'n': nIter = (unsigned int) strtoul (optarg, &tinp, 0);
+                      if ((*tinp != '\0') || (nIter == 0)) {
+                          fprintf (stderr, "Number of iterations must be a positive integer!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'p': nProcs = atoi (optarg);
+                      if (nProcs < 1) {
+                          fprintf (stderr, "Number of processes must be a positive integer!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'k': key = (int) strtol (optarg, &tinp, 0);
+                      if (*tinp != '\0') {
+                          fprintf (stderr, "Error on the access key!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            default:  fprintf (stderr, "Usage: %s [-n iterations] [-p processes] [-k key]\n", argv[0]);
+                      exit (EXIT_FAILURE);
+        }
+    }
+
+    owner = getpid ();
+    if ((semgid = semCreate (key, NSEMS)) == -1)
+       fail ("error on creating the semaphore set");
+    if ((semUp (semgid, MUTEX) == -1) || (semSignal (semgid) == -1))
+       fail ("error on initializing the semaphore set");
+
+    memset (&h, 0, sizeof (h));
+    semUncontended (&h);
+    report ("sem_down_up_uncontended", 1, &h);
+
+    memset (&h, 0, sizeof (h));
+    semPingPong (&h);
+    report ("sem_ping_pong_round_trip", 2, &h);
+
+    memset (&h, 0, sizeof (h));
+    semContended (&h, nProcs);
+    report ("sem_down_up_mutex_contended", nProcs, &h);
+
+    memset (&h, 0, sizeof (h));
+    semConnectCost (&h);
+    report ("sem_connect", 1, &h);
+
+    memset (&h, 0, sizeof (h));
+    shmemConnectCost (&h);
+    report ("shmem_connect_attach", 1, &h);
+
+    if ((fd = mkstemp (nFic)) == -1)
+       fail ("error on creating the log file");
+    close (fd);
+    memset (&h, 0, sizeof (h));
+    saveStateCost (&h, nFic);
+    unlink (nFic);
+    report ("save_state_file", 1, &h);
+
+    memset (&h, 0, sizeof (h));
+    saveStateCost (&h, "");
+    report ("save_state_stdout", 1, &h);
+
+    if (semDestroy (semgid) == -1) {
+       semgid = -1;
+       fail ("error on destructing the semaphore set");
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+/**
+ *  \file lockDomain.c (implementation file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  \brief Entering and leaving the lock domains of the shared data.
+ *
+ *  Each transition enters only the domains it touches (see LK_* and the lock order in sharedDataSync.h), so
+ *  transitions on disjoint domains, such as a reservation and a worker taking an order, run in parallel. All the
+ *  semaphores of the domains are taken in a single atomic operation, and the sequence counter of each domain is
+ *  made odd while it is held, so that snapshots of the state (log, monitor) stay consistent. With the global
+ *  lock, every domain maps to the same semaphore, which is then taken once.
+ *  A transition that changes several lock free fields of an entity is bracketed by the sequence counter of the
+ *  entity instead, which takes no semaphore (the entity is the only writer of its slot).
+ *
+ *  Defined operations:
+ *     \li entering a set of lock domains
+ *     \li leaving a set of lock domains
+ *     \li beginning of a lock free transition of an entity
+ *     \li end of a lock free transition of an entity.
+ */
+
+#include <stdbool.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "sharedDataSync.h"
+#include "semaphore.h"
+#include "seqlock.h"
+
+/* internal functions */
+
+/* semaphores of a set of domains, in lock order and without repetitions */
+static unsigned int domainLocks (SHARED_DATA *sh, unsigned int doms, unsigned int sem[])
+{
+    unsigned int n = 0, k;
+
+    for (unsigned int d = 0; d < NUMDOMAINS; d++) {
+        if ((doms & (1u << d)) == 0) {
+            continue;
+        }
+        for (k = 0; (k < n) && (sem[k] != sh->lock[d]); k++)
+            ;
+        if (k == n) {
+            sem[n++] = sh->lock[d];
+        }
+    }
+    return n;
+}
+
+/* external functions */
+
+/**
+ *  \brief Entering a set of lock domains.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param sh pointer to shared memory region
+ *  \param doms set of lock domains (LK_*)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int ldEnter (int semgid, SHARED_DATA *sh, unsigned int doms)
+{
+    unsigned int sem[NUMDOMAINS];
+
+    if (semDownMany (semgid, domainLocks (sh, doms, sem), sem) == -1) {
+        return -1;
+    }
+    for (unsigned int d = 0; d < NUMDOMAINS; d++) {
+        if ((doms & (1u << d)) != 0) {
+            seqWriteBegin (&sh->fStSeq[d]);
+        }
+    }
+    return 0;
+}
+
+/**
+ *  \brief Leaving a set of lock domains.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param sh pointer to shared memory region
+ *  \param doms set of lock domains (LK_*), as entered
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int ldLeave (int semgid, SHARED_DATA *sh, unsigned int doms)
+{
+    unsigned int sem[NUMDOMAINS], one[NUMDOMAINS], n;
+
+    for (unsigned int d = 0; d < NUMDOMAINS; d++) {
+        if ((doms & (1u << d)) != 0) {
+            seqWriteEnd (&sh->fStSeq[d]);
+        }
+    }
+    n = domainLocks (sh, doms, sem);
+    for (unsigned int k = 0; k < n; k++) {
+        one[k] = 1;
+    }
+    return semUpMany (semgid, n, sem, one);
+}
+
+/**
+ *  \brief Beginning of a lock free transition of an entity.
+ *
+ *  \param sh pointer to shared memory region
+ *  \param ent entity slot (ENT_*) of the calling entity
+ */
+void ldEntityBegin (SHARED_DATA *sh, unsigned int ent)
+{
+    seqWriteBegin (&sh->fStSeq[SEQ_ENTITY (ent)]);
+}
+
+/**
+ *  \brief End of a lock free transition of an entity.
+ *
+ *  \param sh pointer to shared memory region
+ *  \param ent entity slot (ENT_*) of the calling entity
+ */
+void ldEntityEnd (SHARED_DATA *sh, unsigned int ent)
+{
+    seqWriteEnd (&sh->fStSeq[SEQ_ENTITY (ent)]);
+}
@@ -0,0 +1,68 @@
+/**
+ *  \file lockDomain.h (interface file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  \brief Entering and leaving the lock domains of the shared data.
+ *
+ *  Each transition enters only the domains it touches (see LK_* and the lock order in sharedDataSync.h), so
+ *  transitions on disjoint domains, such as a reservation and a worker taking an order, run in parallel. All the
+ *  semaphores of the domains are taken in a single atomic operation, and the sequence counter of each domain is
+ *  made odd while it is held, so that snapshots of the state (log, monitor) stay consistent. With the global
+ *  lock, every domain maps to the same semaphore, which is then taken once.
+ *  A transition that changes several lock free fields of an entity is bracketed by the sequence counter of the
+ *  entity instead, which takes no semaphore (the entity is the only writer of its slot).
+ *
+ *  Defined operations:
+ *     \li entering a set of lock domains
+ *     \li leaving a set of lock domains
+ *     \li beginning of a lock free transition of an entity
+ *     \li end of a lock free transition of an entity.
+ */
+
+#ifndef LOCKDOMAIN_H_
+#define LOCKDOMAIN_H_
+
+#include "sharedDataSync.h"
+
+/**
+ *  \brief Entering a set of lock domains.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param sh pointer to shared memory region
+ *  \param doms set of lock domains (LK_*)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int ldEnter (int semgid, SHARED_DATA *sh, unsigned int doms);
+
+/**
+ *  \brief Leaving a set of lock domains.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param sh pointer to shared memory region
+ *  \param doms set of lock domains (LK_*), as entered
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int ldLeave (int semgid, SHARED_DATA *sh, unsigned int doms);
+
+/**
+ *  \brief Beginning of a lock free transition of an entity.
+ *
+ *  \param sh pointer to shared memory region
+ *  \param ent entity slot (ENT_*) of the calling entity
+ */
+extern void ldEntityBegin (SHARED_DATA *sh, unsigned int ent);
+
+/**
+ *  \brief End of a lock free transition of an entity.
+ *
+ *  \param sh pointer to shared memory region
+ *  \param ent entity slot (ENT_*) of the calling entity
+ */
+extern void ldEntityEnd (SHARED_DATA *sh, unsigned int ent);
+
+#endif /* LOCKDOMAIN_H_ */
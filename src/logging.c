@@ -5,9 +5,14 @@
  *
  *  \brief Logging the internal state of the problem into a file.
  *
+ *  Every record is written under an exclusive lock of the file, and a snapshot is copied while the lock is
+ *  held, so the records of all the entities appear in the order of the states they show. An entity that
+ *  records states it kept inside the critical region holds the lock from before entering it.
+ *
  *  Defined operations:
  *     \li file initialization
- *     \li writing the present full state as a single line at the end of the file.
+ *     \li writing the present full state as a single line at the end of the file
+ *     \li holding and releasing the file across several records.
  *
  *  \author Nuno Lau - December 2019
  */
@@ -18,11 +23,16 @@
 #include <stdbool.h>
 
 #include <sys/types.h>
+#include <sys/file.h>
 #include <unistd.h>
 
 
 #include "probConst.h"
 #include "probDataStruct.h"
+#include "seqlock.h"
+
+/* log file held by the process (NULL, if none) */
+static FILE *held = NULL;
 
 /* internal functions */
 
@@ -47,6 +57,22 @@ static FILE *openLog(char nFic[], char mode[])
     return fic;
 }
 
+/* opening the log for a record: the held file or a newly opened one, locked in both cases */
+static FILE *lockLog(char nFic[])
+{
+    FILE *fic;
+
+    if (held != NULL) {
+        return held;
+    }
+    fic = openLog(nFic,"a");
+    if ((fic != stdout) && (flock (fileno (fic), LOCK_EX) == -1)) {
+        perror ("error on locking the log file");
+        exit (EXIT_FAILURE);
+    }
+    return fic;
+}
+
 static void closeLog(FILE *fic)
 {
     if(fic==stderr || fic == stdout) {
@@ -72,7 +98,7 @@ static void printHeader(FILE *fic, FULL_STAT *p_fSt)
     fprintf(fic," ");
 
     int s;
-    for(s=0; s < p_fSt->nSmokers; s++) {
+    for(s=0; s < p_fSt->nSmokers * p_fSt->nWorkers; s++) {
         fprintf(fic," %s%02d","S",s);
     }
 
@@ -85,13 +111,47 @@ static void printHeader(FILE *fic, FULL_STAT *p_fSt)
 
     fprintf(fic," ");
 
-    for(s=0; s < p_fSt->nSmokers; s++) {
+    for(s=0; s < p_fSt->nSmokers * p_fSt->nWorkers; s++) {
         fprintf(fic," %s%02d","C",s);
     }
 
     fprintf(fic,"\n");
 }
 
+/* writing a record (one line) */
+static void writeState (FILE *fic, FULL_STAT *p_fSt)
+{
+    fprintf(fic,"%3d",p_fSt->st.agentStat);
+    fprintf(fic," ");
+    int w;
+    for(w=0; w < p_fSt->nIngredients; w++) {
+        fprintf(fic,"%4d",p_fSt->st.watcherStat[w]);
+    }
+
+    fprintf(fic," ");
+
+    int s;
+    for(s=0; s < p_fSt->nSmokers * p_fSt->nWorkers; s++) {
+        fprintf(fic,"%4d",p_fSt->st.smokerStat[s]);
+    }
+
+    fprintf(fic," ");
+
+    int i;
+    for(i=0; i < p_fSt->nIngredients; i++) {
+        fprintf(fic,"%4d",p_fSt->ingredients[i]);
+    }
+
+    fprintf(fic," ");
+
+    for(s=0; s < p_fSt->nSmokers * p_fSt->nWorkers; s++) {
+        fprintf(fic,"%4d",p_fSt->nCigarettes[s]);
+    }
+
+    fprintf(fic,"\n");
+    fflush(fic);                                                              /* written before the lock is released */
+}
+
 /* external functions */
 
 /**
@@ -128,9 +188,9 @@ void createLog (char nFic[], FULL_STAT *p_fSt)
  *  The following layout is obeyed for the full state in a single line
  *    \li agent state
  *    \li watchers state 
- *    \li smokers state 
+ *    \li smokers state (one column per worker)
  *    \li inventory 
- *    \li cigarettes of each smoker
+ *    \li cigarettes of each smoker worker
  *
  *  \param nFic name of the logging file
  *  \param p_fSt pointer to the location where the full internal state of the problem is stored
@@ -139,37 +199,60 @@ void saveState (char nFic[], FULL_STAT *p_fSt)
 {
     FILE *fic;                                                                                      /* file descriptor */
 
-    fic = openLog(nFic,"a");
-
-    fprintf(fic,"%3d",p_fSt->st.agentStat);
-    fprintf(fic," ");
-    int w;
-    for(w=0; w < p_fSt->nIngredients; w++) {
-        fprintf(fic,"%4d",p_fSt->st.watcherStat[w]);
+    fic = lockLog(nFic);
+    writeState(fic, p_fSt);
+    if (fic != held) {
+        closeLog(fic);                                                                     /* releases the lock */
     }
+}
 
-    fprintf(fic," ");
+/**
+ *  \brief write a log record of a consistent snapshot of the full internal state.
+ *
+ *  The snapshot is copied under the sequence counters <tt>seq</tt> (one per lock domain and per entity slot of
+ *  the state), so it may be taken outside the critical region, and while the log is locked, so that it is not
+ *  older than the last record.
+ *
+ *  \param nFic name of the logging file
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ *  \param seq sequence counters that protect it
+ *  \param nSeq number of sequence counters
+ */
+void saveStateSnapshot (char nFic[], FULL_STAT *p_fSt, unsigned int seq[], unsigned int nSeq)
+{
+    FILE *fic;                                                                                      /* file descriptor */
+    FULL_STAT snap;                                                                          /* local copy */
 
-    int s;
-    for(s=0; s < p_fSt->nSmokers; s++) {
-        fprintf(fic,"%4d",p_fSt->st.smokerStat[s]);
+    fic = lockLog(nFic);
+    seqReadAll (seq, nSeq, &snap, p_fSt, sizeof (FULL_STAT));
+    writeState(fic, &snap);
+    if (fic != held) {
+        closeLog(fic);                                                                     /* releases the lock */
     }
+}
 
-    fprintf(fic," ");
-
-    int i;
-    for(i=0; i < p_fSt->nIngredients; i++) {
-        fprintf(fic,"%4d",p_fSt->ingredients[i]);
-    }
+/**
+ *  \brief Holding the log file.
+ *
+ *  The file is opened and locked until <tt>releaseLog</tt> is called, and the records of the process are
+ *  written to it meanwhile, so that no other entity writes a record in between.
+ *
+ *  \param nFic name of the logging file
+ */
+void holdLog (char nFic[])
+{
+    held = lockLog(nFic);
+}
 
-    fprintf(fic," ");
+/**
+ *  \brief Releasing the log file held by the process.
+ */
+void releaseLog (void)
+{
+    FILE *fic = held;
 
-    for(s=0; s < p_fSt->nSmokers; s++) {
-        fprintf(fic,"%4d",p_fSt->nCigarettes[s]);
+    held = NULL;
+    if (fic != NULL) {
+        closeLog(fic);                                                                     /* releases the lock */
     }
-
-    fprintf(fic,"\n");
-
-    closeLog(fic);
 }
-
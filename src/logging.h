@@ -5,9 +5,14 @@
  *
  *  \brief Logging the internal state of the problem into a file.
  *
+ *  Every record is written under an exclusive lock of the file, and a snapshot is copied while the lock is
+ *  held, so the records of all the entities appear in the order of the states they show. An entity that
+ *  records states it kept inside the critical region holds the lock from before entering it.
+ *
  *  Defined operations:
  *     \li file initialization
- *     \li writing the present full state as a single line at the end of the file.
+ *     \li writing the present full state as a single line at the end of the file
+ *     \li holding and releasing the file across several records.
  *
  *  \author Nuno Lau - December 2019
  */
@@ -41,4 +46,33 @@ extern void createLog (char nFic[], FULL_STAT *p_fSt);
  */
 extern void saveState (char nFic[], FULL_STAT *p_fSt);
 
+/**
+ *  \brief write a log record of a consistent snapshot of the full internal state.
+ *
+ *  The snapshot is copied under the sequence counters <tt>seq</tt> (one per lock domain and per entity slot of
+ *  the state), so it may be taken outside the critical region, and while the log is locked, so that it is not
+ *  older than the last record.
+ *
+ *  \param nFic name of the logging file
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ *  \param seq sequence counters that protect it
+ *  \param nSeq number of sequence counters
+ */
+extern void saveStateSnapshot (char nFic[], FULL_STAT *p_fSt, unsigned int seq[], unsigned int nSeq);
+
+/**
+ *  \brief Holding the log file.
+ *
+ *  The file is opened and locked until <tt>releaseLog</tt> is called, and the records of the process are
+ *  written to it meanwhile, so that no other entity writes a record in between.
+ *
+ *  \param nFic name of the logging file
+ */
+extern void holdLog (char nFic[]);
+
+/**
+ *  \brief Releasing the log file held by the process.
+ */
+extern void releaseLog (void);
+
 #endif /* LOGGING_H_ */
@@ -0,0 +1,70 @@
+/**
+ *  \file multiCall.c (implementation file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  Multi-call binary: the agent, the watcher, the smoker, the matcher and the launcher in a single executable.
+ *
+ *  The program is chosen by the name the binary was invoked with (a link named <tt>agent</tt>, for
+ *  instance) or, failing that, by the first argument:
+ *     \li <tt>multicall probSemSharedMemSmokers [options] [logfile]</tt>
+ *     \li <tt>multicall agent logfile key errfile</tt>, and so on.
+ *
+ *  All the processes of a simulation then run the same image and share its text pages; with
+ *  <tt>-f</tt>, the launcher does not even exec them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "entityMain.h"
+
+/** \brief programs of the multi-call binary */
+static const struct { const char *name; ENTRY entry; } program[] = {
+    { "agent",                   agentMain },
+    { "watcher",                 watcherMain },
+    { "smoker",                  smokerMain },
+    { "matcher",                 matcherMain },
+    { "probSemSharedMemSmokers", launcherMain }
+};
+
+/**
+ *  \brief Finding the entry point of a program of the multi-call binary.
+ *
+ *  \param name program name (a path is allowed, only its last component is used)
+ *
+ *  \return entry point, or NULL if there is no program with that name
+ */
+ENTRY entryFind (const char *name)
+{
+    const char *base = strrchr (name, '/');
+
+    base = (base == NULL) ? name : base + 1;
+    for (unsigned int p = 0; p < sizeof (program) / sizeof (program[0]); p++) {
+        if (strcmp (base, program[p].name) == 0) {
+            return program[p].entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ *  \brief Main program.
+ *
+ *  Its role is dispatching to the program named by <tt>argv[0]</tt> or by the first argument.
+ */
+int main (int argc, char *argv[])
+{
+    ENTRY entry;
+
+    if ((entry = entryFind (argv[0])) != NULL) {
+        return entry (argc, argv);
+    }
+    if ((argc > 1) && ((entry = entryFind (argv[1])) != NULL)) {
+        return entry (argc - 1, argv + 1);
+    }
+
+    fprintf (stderr, "Usage: %s agent|watcher|smoker|matcher|probSemSharedMemSmokers [arguments]\n", argv[0]);
+    return EXIT_FAILURE;
+}
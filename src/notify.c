@@ -0,0 +1,216 @@
+/**
+ *  \file notify.c (implementation file)
+ *
+ *  \brief Notification channels on eventfd, for event loop engines.
+ *
+ *  A channel is an <tt>eventfd</tt> with semaphore semantics: a post adds to its counter and each take removes
+ *  one unit, so a channel behaves as a semaphore that any number of threads can wait on through <tt>epoll</tt>,
+ *  together with many other channels (unlike a SysV semaphore, on which a process blocks alone). Channels are
+ *  non-blocking: a take of an empty channel fails instead of blocking, so several loops may watch the same
+ *  channel and the loser of a race just goes on. A timer (<tt>timerfd</tt>) lets a loop watch the end of its
+ *  sleeps in the same set.
+ *
+ *  Defined operations:
+ *     \li creation of a channel
+ *     \li post and take operations on a channel
+ *     \li creation of a watch set
+ *     \li addition and removal of a descriptor to and from a watch set
+ *     \li waiting on a watch set
+ *     \li creation, arming and expiration of a timer.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include "notify.h"
+
+/** \brief maximum number of ready descriptors reported by a wait */
+#define  NFMAXREADY       256
+
+/**
+ *  \brief Creation of a channel.
+ *
+ *  \return channel descriptor, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int nfChannel (void)
+{
+    return eventfd (0, EFD_SEMAPHORE | EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+/**
+ *  \brief Post operation.
+ *
+ *  Adds a number of units to the channel, waking the loops that watch it.
+ *
+ *  \param ch channel descriptor
+ *  \param n number of units
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int nfPost (int ch, unsigned int n)
+{
+    uint64_t v = n;
+
+    while (write (ch, &v, sizeof (v)) == -1) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ *  \brief Take operation.
+ *
+ *  Removes one unit from the channel, if it has any.
+ *
+ *  \param ch channel descriptor
+ *
+ *  \return \c 1, if a unit was taken
+ *  \return \c 0, if the channel is empty
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int nfTake (int ch)
+{
+    uint64_t v;
+
+    while (read (ch, &v, sizeof (v)) == -1) {
+        if (errno == EAGAIN) {                                    /* empty, or taken by another loop first */
+            return 0;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return 1;
+}
+
+/**
+ *  \brief Creation of a watch set.
+ *
+ *  \return watch set descriptor, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int nfSet (void)
+{
+    return epoll_create1 (EPOLL_CLOEXEC);
+}
+
+/**
+ *  \brief Addition of a descriptor (channel or timer) to a watch set.
+ *
+ *  The descriptor is reported by <tt>nfWait</tt>, with the given tag, while it has units (or expirations).
+ *
+ *  \param set watch set descriptor
+ *  \param fd descriptor
+ *  \param tag tag of the descriptor
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int nfWatch (int set, int fd, uint64_t tag)
+{
+    struct epoll_event ev;
+
+    memset (&ev, 0, sizeof (ev));
+    ev.events = EPOLLIN;                                                                    /* level triggered */
+    ev.data.u64 = tag;
+    return epoll_ctl (set, EPOLL_CTL_ADD, fd, &ev);
+}
+
+/**
+ *  \brief Removal of a descriptor from a watch set.
+ *
+ *  \param set watch set descriptor
+ *  \param fd descriptor
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int nfUnwatch (int set, int fd)
+{
+    return epoll_ctl (set, EPOLL_CTL_DEL, fd, NULL);
+}
+
+/**
+ *  \brief Waiting on a watch set.
+ *
+ *  \param set watch set descriptor
+ *  \param tags tags of the ready descriptors
+ *  \param max maximum number of tags
+ *  \param timeoutMs timeout (ms, -1 waits forever)
+ *
+ *  \return number of ready descriptors (0 on timeout), upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int nfWait (int set, uint64_t tags[], int max, int timeoutMs)
+{
+    struct epoll_event ev[NFMAXREADY];
+    int n;
+
+    if (max > NFMAXREADY) {
+        max = NFMAXREADY;
+    }
+    while ((n = epoll_wait (set, ev, max, timeoutMs)) == -1) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        tags[i] = ev[i].data.u64;
+    }
+    return n;
+}
+
+/**
+ *  \brief Creation of a timer.
+ *
+ *  \return timer descriptor, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int nfTimer (void)
+{
+    return timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+}
+
+/**
+ *  \brief Arming of a timer.
+ *
+ *  \param timer timer descriptor
+ *  \param deadlineNs expiration time (monotonic clock, in ns; 0 disarms the timer)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int nfArm (int timer, uint64_t deadlineNs)
+{
+    struct itimerspec its;
+
+    memset (&its, 0, sizeof (its));
+    its.it_value.tv_sec = (time_t) (deadlineNs / 1000000000ull);
+    its.it_value.tv_nsec = (long) (deadlineNs % 1000000000ull);
+    return timerfd_settime (timer, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+/**
+ *  \brief Expiration of a timer.
+ *
+ *  Clears the expirations of the timer.
+ *
+ *  \param timer timer descriptor
+ *
+ *  \return \c 1, if the timer expired
+ *  \return \c 0, if it did not
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int nfExpired (int timer)
+{
+    return nfTake (timer);                             /* reads (and clears) the number of expirations */
+}
@@ -0,0 +1,139 @@
+/**
+ *  \file notify.h (interface file)
+ *
+ *  \brief Notification channels on eventfd, for event loop engines.
+ *
+ *  A channel is an <tt>eventfd</tt> with semaphore semantics: a post adds to its counter and each take removes
+ *  one unit, so a channel behaves as a semaphore that any number of threads can wait on through <tt>epoll</tt>,
+ *  together with many other channels (unlike a SysV semaphore, on which a process blocks alone). Channels are
+ *  non-blocking: a take of an empty channel fails instead of blocking, so several loops may watch the same
+ *  channel and the loser of a race just goes on. A timer (<tt>timerfd</tt>) lets a loop watch the end of its
+ *  sleeps in the same set.
+ *
+ *  Defined operations:
+ *     \li creation of a channel
+ *     \li post and take operations on a channel
+ *     \li creation of a watch set
+ *     \li addition and removal of a descriptor to and from a watch set
+ *     \li waiting on a watch set
+ *     \li creation, arming and expiration of a timer.
+ */
+
+#ifndef NOTIFY_H_
+#define NOTIFY_H_
+
+#include <stdint.h>
+
+/**
+ *  \brief Creation of a channel.
+ *
+ *  \return channel descriptor, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int nfChannel (void);
+
+/**
+ *  \brief Post operation.
+ *
+ *  Adds a number of units to the channel, waking the loops that watch it.
+ *
+ *  \param ch channel descriptor
+ *  \param n number of units
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int nfPost (int ch, unsigned int n);
+
+/**
+ *  \brief Take operation.
+ *
+ *  Removes one unit from the channel, if it has any.
+ *
+ *  \param ch channel descriptor
+ *
+ *  \return \c 1, if a unit was taken
+ *  \return \c 0, if the channel is empty
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int nfTake (int ch);
+
+/**
+ *  \brief Creation of a watch set.
+ *
+ *  \return watch set descriptor, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int nfSet (void);
+
+/**
+ *  \brief Addition of a descriptor (channel or timer) to a watch set.
+ *
+ *  The descriptor is reported by <tt>nfWait</tt>, with the given tag, while it has units (or expirations).
+ *
+ *  \param set watch set descriptor
+ *  \param fd descriptor
+ *  \param tag tag of the descriptor
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int nfWatch (int set, int fd, uint64_t tag);
+
+/**
+ *  \brief Removal of a descriptor from a watch set.
+ *
+ *  \param set watch set descriptor
+ *  \param fd descriptor
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int nfUnwatch (int set, int fd);
+
+/**
+ *  \brief Waiting on a watch set.
+ *
+ *  \param set watch set descriptor
+ *  \param tags tags of the ready descriptors
+ *  \param max maximum number of tags
+ *  \param timeoutMs timeout (ms, -1 waits forever)
+ *
+ *  \return number of ready descriptors (0 on timeout), upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int nfWait (int set, uint64_t tags[], int max, int timeoutMs);
+
+/**
+ *  \brief Creation of a timer.
+ *
+ *  \return timer descriptor, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int nfTimer (void);
+
+/**
+ *  \brief Arming of a timer.
+ *
+ *  \param timer timer descriptor
+ *  \param deadlineNs expiration time (monotonic clock, in ns; 0 disarms the timer)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int nfArm (int timer, uint64_t deadlineNs);
+
+/**
+ *  \brief Expiration of a timer.
+ *
+ *  Clears the expirations of the timer.
+ *
+ *  \param timer timer descriptor
+ *
+ *  \return \c 1, if the timer expired
+ *  \return \c 0, if it did not
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int nfExpired (int timer);
+
+#endif /* NOTIFY_H_ */
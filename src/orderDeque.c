@@ -0,0 +1,134 @@
+/**
+ *  \file orderDeque.c (implementation file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  \brief Dispatch of ready orders to the workers of the smokers.
+ *
+ *  Each smoker worker has its own deque and its own wake semaphore (<tt>wait2Ings</tt>), upped once for every
+ *  order pushed onto the deque, so the worker an order is routed to is the one woken up to serve it. A worker
+ *  going idle may steal from a busy peer, taking over the wake-up of the stolen order.
+ *
+ *  Defined operations:
+ *     \li pushing a ready order onto the deque of one of the workers of a smoker
+ *     \li taking the oldest order of the deque of a worker
+ *     \li choosing the peer a worker going idle may steal an order from.
+ *
+ *  Every operation must be called inside the dispatch lock domain (the states of the workers are read only as a
+ *  hint of which worker is idle).
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "sharedDataSync.h"
+
+/* internal functions */
+
+static int selectWorker (SHARED_DATA *sh, int smoker)
+{
+    int first = smoker * sh->fSt.nWorkers;
+    int best = first;
+    unsigned int len, bestLen = DEQUESIZE + 1;
+
+    for (int w = first; w < first + sh->fSt.nWorkers; w++) {
+        len = sh->deque[w].bottom - sh->deque[w].top;
+        if ((len == 0) && (__atomic_load_n (&sh->fSt.st.smokerStat[w], __ATOMIC_RELAXED) == WAITING_2ING)) {
+            return w;
+        }
+        if (len < bestLen) {
+            best = w;
+            bestLen = len;
+        }
+    }
+
+    return best;
+}
+
+/* external functions */
+
+/**
+ *  \brief Pushing a ready order onto the deque of one of the workers of a smoker.
+ *
+ *  An idle worker with an empty deque is preferred; otherwise the worker with the shortest deque is chosen.
+ *
+ *  \param sh pointer to shared memory region
+ *  \param smoker id of the smoker
+ *  \param order id of the order
+ *
+ *  \return index of the selected worker, upon success
+ *  \return -\c 1, when the deque of the selected worker is full
+ */
+int dqPush (SHARED_DATA *sh, int smoker, unsigned int order)
+{
+    int w = selectWorker (sh, smoker);
+    DEQUE *dq = &sh->deque[w];
+
+    if (dq->bottom - dq->top >= DEQUESIZE) {
+        return -1;
+    }
+    dq->order[dq->bottom % DEQUESIZE] = order;
+    dq->bottom++;
+
+    return w;
+}
+
+/**
+ *  \brief Taking the oldest order of the deque of a worker.
+ *
+ *  Used by the owner of the deque when it is woken up for an order, and by a thief that took over the wake-up
+ *  of one of the orders of a peer (see <tt>dqVictim</tt>), so orders are served in arrival order.
+ *
+ *  \param sh pointer to shared memory region
+ *  \param worker index of the smoker worker that owns the deque
+ *  \param pOrder pointer to the location where the id of the order is stored
+ *
+ *  \return true if an order was taken; false if the deque is empty
+ */
+bool dqTake (SHARED_DATA *sh, int worker, unsigned int *pOrder)
+{
+    DEQUE *dq = &sh->deque[worker];
+
+    if (dq->bottom == dq->top) {
+        return false;
+    }
+    *pOrder = dq->order[dq->top % DEQUESIZE];
+    dq->top++;
+    return true;
+}
+
+/**
+ *  \brief Choosing the peer a worker going idle may steal an order from.
+ *
+ *  Stealing is a fallback: it is only considered when the own deque of the worker is empty, and the busiest
+ *  peer of the same smoker is chosen. Each order pushed onto a deque comes with an <em>up</em> of the wake
+ *  semaphore of its owner, so the thief takes an order only if it takes over that <em>up</em> as well (with a
+ *  non-blocking <em>down</em>); otherwise the owner is already on its way to serve it.
+ *
+ *  \param sh pointer to shared memory region
+ *  \param worker index of the smoker worker going idle
+ *
+ *  \return index of the peer, upon success
+ *  \return -\c 1, when the own deque of the worker is not empty or no peer has pending orders
+ */
+int dqVictim (SHARED_DATA *sh, int worker)
+{
+    int first = (worker / sh->fSt.nWorkers) * sh->fSt.nWorkers;
+    int victim = -1;
+    unsigned int len, bestLen = 0;
+
+    if (sh->deque[worker].bottom != sh->deque[worker].top) {
+        return -1;
+    }
+    for (int w = first; w < first + sh->fSt.nWorkers; w++) {
+        len = sh->deque[w].bottom - sh->deque[w].top;
+        if (len > bestLen) {
+            victim = w;
+            bestLen = len;
+        }
+    }
+
+    return victim;
+}
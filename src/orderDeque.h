@@ -0,0 +1,72 @@
+/**
+ *  \file orderDeque.h (interface file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  \brief Dispatch of ready orders to the workers of the smokers.
+ *
+ *  Each smoker worker has its own deque and its own wake semaphore (<tt>wait2Ings</tt>), upped once for every
+ *  order pushed onto the deque, so the worker an order is routed to is the one woken up to serve it. A worker
+ *  going idle may steal from a busy peer, taking over the wake-up of the stolen order.
+ *
+ *  Defined operations:
+ *     \li pushing a ready order onto the deque of one of the workers of a smoker
+ *     \li taking the oldest order of the deque of a worker
+ *     \li choosing the peer a worker going idle may steal an order from.
+ *
+ *  Every operation must be called inside the dispatch lock domain (the states of the workers are read only as a
+ *  hint of which worker is idle).
+ */
+
+#ifndef ORDERDEQUE_H_
+#define ORDERDEQUE_H_
+
+#include <stdbool.h>
+
+#include "sharedDataSync.h"
+
+/**
+ *  \brief Pushing a ready order onto the deque of one of the workers of a smoker.
+ *
+ *  An idle worker with an empty deque is preferred; otherwise the worker with the shortest deque is chosen.
+ *
+ *  \param sh pointer to shared memory region
+ *  \param smoker id of the smoker
+ *  \param order id of the order
+ *
+ *  \return index of the selected worker, upon success
+ *  \return -\c 1, when the deque of the selected worker is full
+ */
+extern int dqPush (SHARED_DATA *sh, int smoker, unsigned int order);
+
+/**
+ *  \brief Taking the oldest order of the deque of a worker.
+ *
+ *  Used by the owner of the deque when it is woken up for an order, and by a thief that took over the wake-up
+ *  of one of the orders of a peer (see <tt>dqVictim</tt>), so orders are served in arrival order.
+ *
+ *  \param sh pointer to shared memory region
+ *  \param worker index of the smoker worker that owns the deque
+ *  \param pOrder pointer to the location where the id of the order is stored
+ *
+ *  \return true if an order was taken; false if the deque is empty
+ */
+extern bool dqTake (SHARED_DATA *sh, int worker, unsigned int *pOrder);
+
+/**
+ *  \brief Choosing the peer a worker going idle may steal an order from.
+ *
+ *  Stealing is a fallback: it is only considered when the own deque of the worker is empty, and the busiest
+ *  peer of the same smoker is chosen. Each order pushed onto a deque comes with an <em>up</em> of the wake
+ *  semaphore of its owner, so the thief takes an order only if it takes over that <em>up</em> as well (with a
+ *  non-blocking <em>down</em>); otherwise the owner is already on its way to serve it.
+ *
+ *  \param sh pointer to shared memory region
+ *  \param worker index of the smoker worker going idle
+ *
+ *  \return index of the peer, upon success
+ *  \return -\c 1, when the own deque of the worker is not empty or no peer has pending orders
+ */
+extern int dqVictim (SHARED_DATA *sh, int worker);
+
+#endif /* ORDERDEQUE_H_ */
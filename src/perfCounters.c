@@ -0,0 +1,230 @@
+/**
+ *  \file perfCounters.c (implementation file)
+ *
+ *  \brief Optional hardware and software counters per phase of the life cycle of an entity.
+ *
+ *  Only built when PERFCOUNTERS is defined (make PERF=1). Each entity opens a group of
+ *  <tt>perf_event_open</tt> counters on itself (cycles, instructions, cache misses and context switches),
+ *  reads them at the end of every function of its life cycle and, at exit, appends to PERFFILE a JSON
+ *  line with the totals of each phase. Counters the kernel refuses (no PMU, perf_event_paranoid) are
+ *  reported as null.
+ *  Without PERFCOUNTERS the macros expand to nothing, so there is no overhead.
+ *
+ *  Defined operations:
+ *     \li opening of the counters
+ *     \li attribution of the counts since the previous reading to a phase
+ *     \li writing of the report.
+ */
+
+#include "perfCounters.h"
+
+#ifdef PERFCOUNTERS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/** \brief number of counters */
+#define  NUMCOUNTERS      4
+
+/** \brief type, configuration and report name of each counter */
+static const struct { uint32_t type; uint64_t config; const char *name; } counter[NUMCOUNTERS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES,       "cycles" },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,     "instructions" },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES,     "cache_misses" },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "context_switches" }
+};
+
+/** \brief file descriptor of the group leader (-1 if no counter could be opened) */
+static int leader = -1;
+
+/** \brief position of each counter in a group read (-1 if not available) */
+static int slot[NUMCOUNTERS];
+
+/** \brief number of counters in the group */
+static int nOpen = 0;
+
+/** \brief counts at the previous reading */
+static uint64_t last[NUMCOUNTERS];
+
+/** \brief entity name */
+static char entName[32];
+
+/** \brief entity id */
+static int entId = -1;
+
+/** \brief number of phases */
+static int nPh = 0;
+
+/** \brief phase names */
+static const char *phName[PERFPHASES];
+
+/** \brief number of readings of each phase */
+static uint64_t calls[PERFPHASES];
+
+/** \brief totals of each counter in each phase */
+static uint64_t total[PERFPHASES][NUMCOUNTERS];
+
+/**
+ *  \brief Opening of one counter.
+ *
+ *  Kernel events are counted when allowed, since they include the cost of the IPC system calls.
+ *
+ *  \param k counter index
+ *  \param group group leader (-1 for a new group)
+ *
+ *  \return file descriptor, or -1 if not available
+ */
+static int openCounter (int k, int group)
+{
+    struct perf_event_attr attr;
+    int fd;
+
+    memset (&attr, 0, sizeof (attr));
+    attr.size = sizeof (attr);
+    attr.type = counter[k].type;
+    attr.config = counter[k].config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.disabled = (group == -1);
+    attr.exclude_hv = 1;
+    if ((fd = syscall (SYS_perf_event_open, &attr, 0, -1, group, 0)) == -1) {
+        attr.exclude_kernel = 1;                                         /* restricted by perf_event_paranoid */
+        fd = syscall (SYS_perf_event_open, &attr, 0, -1, group, 0);
+    }
+    return fd;
+}
+
+/**
+ *  \brief Reading of the counters.
+ *
+ *  \param v counts (unavailable counters are left untouched)
+ */
+static void readCounters (uint64_t v[])
+{
+    uint64_t buf[1 + NUMCOUNTERS];
+
+    if ((leader == -1) || (read (leader, buf, sizeof (buf)) < (ssize_t) ((1 + nOpen) * sizeof (uint64_t)))) {
+        return;
+    }
+    for (int k = 0; k < NUMCOUNTERS; k++) {
+        if (slot[k] >= 0) {
+            v[k] = buf[1 + slot[k]];
+        }
+    }
+}
+
+/**
+ *  \brief Opening of the counters of the calling process.
+ *
+ *  The counts start at the call.
+ *
+ *  \param entity name of the entity
+ *  \param id entity id (-1 if there is only one)
+ *  \param nPhases number of phases
+ *  \param ... name of each phase (strings)
+ */
+void perfOpen (const char *entity, int id, int nPhases, ...)
+{
+    va_list ap;
+    int fd;
+
+    strncpy (entName, entity, sizeof (entName) - 1);
+    entId = id;
+    nPh = (nPhases < PERFPHASES) ? nPhases : PERFPHASES;
+    va_start (ap, nPhases);
+    for (int p = 0; p < nPh; p++) {
+        phName[p] = va_arg (ap, const char *);
+    }
+    va_end (ap);
+
+    for (int k = 0; k < NUMCOUNTERS; k++) {
+        slot[k] = -1;
+        if ((fd = openCounter (k, leader)) == -1) {
+            continue;
+        }
+        if (leader == -1) {
+            leader = fd;
+        }
+        slot[k] = nOpen++;
+    }
+    if (leader == -1) {
+        return;
+    }
+    ioctl (leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl (leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    readCounters (last);
+}
+
+/**
+ *  \brief Attribution of the counts since the previous reading to a phase.
+ *
+ *  \param phase phase index
+ */
+void perfPhase (int phase)
+{
+    uint64_t now[NUMCOUNTERS];
+
+    if ((phase < 0) || (phase >= nPh)) {
+        return;
+    }
+    memcpy (now, last, sizeof (now));
+    readCounters (now);
+    for (int k = 0; k < NUMCOUNTERS; k++) {
+        total[phase][k] += now[k] - last[k];
+    }
+    memcpy (last, now, sizeof (last));
+    calls[phase] += 1;
+}
+
+/**
+ *  \brief Writing of the report (one JSON line appended to PERFFILE) and closing of the counters.
+ */
+void perfReport (void)
+{
+    char line[4096];
+    int len, fd;
+
+    len = snprintf (line, sizeof (line), "{\"entity\":\"%s\",\"id\":%d,\"pid\":%d,\"phases\":{", entName, entId,
+                    (int) getpid ());
+    for (int p = 0; (p < nPh) && (len < (int) sizeof (line)); p++) {
+        len += snprintf (line + len, sizeof (line) - len, "%s\"%s\":{\"calls\":%llu", (p > 0) ? "," : "",
+                         phName[p], (unsigned long long) calls[p]);
+        for (int k = 0; (k < NUMCOUNTERS) && (len < (int) sizeof (line)); k++) {
+            if (slot[k] >= 0) {
+                len += snprintf (line + len, sizeof (line) - len, ",\"%s\":%llu", counter[k].name,
+                                 (unsigned long long) total[p][k]);
+            }
+            else len += snprintf (line + len, sizeof (line) - len, ",\"%s\":null", counter[k].name);
+        }
+        if (len < (int) sizeof (line)) {
+            len += snprintf (line + len, sizeof (line) - len, "}");
+        }
+    }
+    if (len < (int) sizeof (line) - 2) {
+        len += snprintf (line + len, sizeof (line) - len, "}}\n");
+    }
+    else len = sizeof (line) - 1;
+
+    /* a single write on an O_APPEND file keeps the lines of concurrent entities apart */
+    if ((fd = open (PERFFILE, O_WRONLY | O_CREAT | O_APPEND, 0644)) != -1) {
+        if (write (fd, line, len) != len) {
+            perror ("error on writing the counters report");
+        }
+        close (fd);
+    }
+    if (leader != -1) {
+        close (leader);
+        leader = -1;
+    }
+}
+
+#endif /* PERFCOUNTERS */
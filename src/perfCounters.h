@@ -0,0 +1,66 @@
+/**
+ *  \file perfCounters.h (interface file)
+ *
+ *  \brief Optional hardware and software counters per phase of the life cycle of an entity.
+ *
+ *  Only built when PERFCOUNTERS is defined (make PERF=1). Each entity opens a group of
+ *  <tt>perf_event_open</tt> counters on itself (cycles, instructions, cache misses and context switches),
+ *  reads them at the end of every function of its life cycle and, at exit, appends to PERFFILE a JSON
+ *  line with the totals of each phase. Counters the kernel refuses (no PMU, perf_event_paranoid) are
+ *  reported as null.
+ *  Without PERFCOUNTERS the macros expand to nothing, so there is no overhead.
+ *
+ *  Defined operations:
+ *     \li opening of the counters
+ *     \li attribution of the counts since the previous reading to a phase
+ *     \li writing of the report.
+ */
+
+#ifndef PERFCOUNTERS_H_
+#define PERFCOUNTERS_H_
+
+/** \brief name of the file the reports are appended to */
+#define  PERFFILE         "perf.json"
+
+/** \brief maximum number of phases of an entity */
+#define  PERFPHASES       8
+
+#ifdef PERFCOUNTERS
+
+/**
+ *  \brief Opening of the counters of the calling process.
+ *
+ *  The counts start at the call.
+ *
+ *  \param entity name of the entity
+ *  \param id entity id (-1 if there is only one)
+ *  \param nPhases number of phases
+ *  \param ... name of each phase (strings)
+ */
+extern void perfOpen (const char *entity, int id, int nPhases, ...);
+
+/**
+ *  \brief Attribution of the counts since the previous reading to a phase.
+ *
+ *  \param phase phase index
+ */
+extern void perfPhase (int phase);
+
+/**
+ *  \brief Writing of the report (one JSON line appended to PERFFILE) and closing of the counters.
+ */
+extern void perfReport (void);
+
+#define  PERF_OPEN(...)   perfOpen (__VA_ARGS__)
+#define  PERF_PHASE(ph)   perfPhase (ph)
+#define  PERF_REPORT()    perfReport ()
+
+#else
+
+#define  PERF_OPEN(...)   ((void) 0)
+#define  PERF_PHASE(ph)   ((void) 0)
+#define  PERF_REPORT()    ((void) 0)
+
+#endif /* PERFCOUNTERS */
+
+#endif /* PERFCOUNTERS_H_ */
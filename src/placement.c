@@ -0,0 +1,197 @@
+/**
+ *  \file placement.c (implementation file)
+ *
+ *  \brief CPU and memory placement of the entities (affinity and NUMA binding).
+ *
+ *  Placements are given as CPU lists (<tt>0-3,8</tt>) or as a NUMA node (<tt>node1</tt>, all its CPUs).
+ *  Memory is bound with <tt>mbind</tt> on the shared mapping, which sets the policy of the shared segment
+ *  itself, so it holds whichever process touches the pages first. No NUMA library is needed.
+ *
+ *  Defined operations:
+ *     \li parsing of a placement
+ *     \li node of a CPU
+ *     \li pinning of a process to a set of CPUs
+ *     \li binding of a memory range to a node.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include "placement.h"
+
+/**
+ *  \brief Parsing of a CPU list.
+ *
+ *  \param list CPU list (<tt>0-3,8</tt>)
+ *  \param cpus pointer to the CPU set
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if the list is not valid
+ */
+static int parseList (const char *list, cpu_set_t *cpus)
+{
+    const char *p = list;
+    char *end;
+    long lo, hi;
+
+    CPU_ZERO (cpus);
+    while (*p != '\0') {
+        lo = strtol (p, &end, 10);
+        if ((end == p) || (lo < 0)) {
+            return -1;
+        }
+        hi = lo;
+        if (*end == '-') {
+            p = end + 1;
+            hi = strtol (p, &end, 10);
+            if ((end == p) || (hi < lo)) {
+                return -1;
+            }
+        }
+        if (hi >= CPU_SETSIZE) {
+            return -1;
+        }
+        for (long c = lo; c <= hi; c++) {
+            CPU_SET (c, cpus);
+        }
+        p = end;
+        if (*p == ',') {
+            p += 1;
+        }
+        else if ((*p != '\0') && (*p != '\n')) {
+            return -1;
+        }
+        else break;
+    }
+    return CPU_COUNT (cpus) > 0 ? 0 : -1;
+}
+
+/**
+ *  \brief Parsing of a placement.
+ *
+ *  \param spec CPU list (<tt>0-3,8</tt>) or node (<tt>node1</tt>)
+ *  \param pl pointer to the placement
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if the specification is not valid
+ */
+int plParse (const char *spec, PLACEMENT *pl)
+{
+    char name[64], list[1024];
+    FILE *fic;
+    char *end;
+    long node;
+
+    if (strncmp (spec, "node", 4) == 0) {
+        node = strtol (spec + 4, &end, 10);
+        if ((end == spec + 4) || (*end != '\0') || (node < 0)) {
+            return -1;
+        }
+        sprintf (name, "/sys/devices/system/node/node%ld/cpulist", node);
+        if ((fic = fopen (name, "r")) == NULL) {
+            return -1;
+        }
+        if (fgets (list, sizeof (list), fic) == NULL) {
+            fclose (fic);
+            return -1;
+        }
+        fclose (fic);
+        if (parseList (list, &pl->cpus) == -1) {
+            return -1;
+        }
+        pl->node = (int) node;
+    }
+    else {
+        if (parseList (spec, &pl->cpus) == -1) {
+            return -1;
+        }
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET (c, &pl->cpus)) {
+                pl->node = plNodeOfCpu (c);
+                break;
+            }
+        }
+    }
+    pl->on = true;
+    return 0;
+}
+
+/**
+ *  \brief NUMA node of a CPU.
+ *
+ *  \param cpu CPU number
+ *
+ *  \return node number, or -1 if unknown
+ */
+int plNodeOfCpu (int cpu)
+{
+    char name[64];
+
+    for (int node = 0; node < 1024; node++) {
+        sprintf (name, "/sys/devices/system/cpu/cpu%d/node%d", cpu, node);
+        if (access (name, F_OK) == 0) {
+            return node;
+        }
+        sprintf (name, "/sys/devices/system/node/node%d", node);
+        if (access (name, F_OK) != 0) {
+            break;                                                          /* nodes are numbered without gaps */
+        }
+    }
+    return -1;
+}
+
+/**
+ *  \brief Pinning of a process to the CPUs of a placement.
+ *
+ *  \param pid process identifier (0 for the calling process)
+ *  \param pl pointer to the placement
+ *
+ *  \return \c 0, upon success (or if the placement was not given)
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int plPin (pid_t pid, const PLACEMENT *pl)
+{
+    if (!pl->on) {
+        return 0;
+    }
+    return sched_setaffinity (pid, sizeof (cpu_set_t), &pl->cpus);
+}
+
+/**
+ *  \brief Binding of a memory range to a node.
+ *
+ *  Only the pages entirely inside the range are bound, so that neighbouring data is not moved.
+ *  Pages already present are migrated.
+ *
+ *  \param addr start of the range
+ *  \param len length of the range (bytes)
+ *  \param node node number
+ *
+ *  \return \c 0, upon success (or if no page is entirely inside the range)
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int plBind (void *addr, size_t len, int node)
+{
+    uintptr_t page = (uintptr_t) sysconf (_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t) addr + page - 1) & ~(page - 1);
+    uintptr_t end = ((uintptr_t) addr + len) & ~(page - 1);
+    unsigned long mask[16];                                                               /* up to 1024 nodes */
+
+    if ((node < 0) || (node >= (int) (8 * sizeof (mask)))) {
+        return -1;
+    }
+    if (end <= start) {
+        return 0;
+    }
+    memset (mask, 0, sizeof (mask));
+    mask[node / (8 * sizeof (long))] = 1UL << (node % (8 * sizeof (long)));
+    return (int) syscall (SYS_mbind, (void *) start, (unsigned long) (end - start), MPOL_BIND, mask,
+                          (unsigned long) (8 * sizeof (mask)), MPOL_MF_MOVE);
+}
@@ -0,0 +1,87 @@
+/**
+ *  \file placement.h (interface file)
+ *
+ *  \brief CPU and memory placement of the entities (affinity and NUMA binding).
+ *
+ *  Placements are given as CPU lists (<tt>0-3,8</tt>) or as a NUMA node (<tt>node1</tt>, all its CPUs).
+ *  Memory is bound with <tt>mbind</tt> on the shared mapping, which sets the policy of the shared segment
+ *  itself, so it holds whichever process touches the pages first. No NUMA library is needed.
+ *
+ *  Defined operations:
+ *     \li parsing of a placement
+ *     \li node of a CPU
+ *     \li pinning of a process to a set of CPUs
+ *     \li binding of a memory range to a node.
+ */
+
+#ifndef PLACEMENT_H_
+#define PLACEMENT_H_
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <sched.h>
+#include <sys/types.h>
+
+/**
+ *  \brief Definition of <em>placement</em> data type.
+ */
+typedef struct {
+    /** \brief flag set when the placement was given */
+    bool on;
+    /** \brief CPUs */
+    cpu_set_t cpus;
+    /** \brief NUMA node of the CPUs (of the first one, if they span several; -1 if unknown) */
+    int node;
+} PLACEMENT;
+
+/**
+ *  \brief Parsing of a placement.
+ *
+ *  \param spec CPU list (<tt>0-3,8</tt>) or node (<tt>node1</tt>)
+ *  \param pl pointer to the placement
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if the specification is not valid
+ */
+extern int plParse (const char *spec, PLACEMENT *pl);
+
+/**
+ *  \brief NUMA node of a CPU.
+ *
+ *  \param cpu CPU number
+ *
+ *  \return node number, or -1 if unknown
+ */
+extern int plNodeOfCpu (int cpu);
+
+/**
+ *  \brief Pinning of a process to the CPUs of a placement.
+ *
+ *  \param pid process identifier (0 for the calling process)
+ *  \param pl pointer to the placement
+ *
+ *  \return \c 0, upon success (or if the placement was not given)
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int plPin (pid_t pid, const PLACEMENT *pl);
+
+/**
+ *  \brief Binding of a memory range to a node.
+ *
+ *  Only the pages entirely inside the range are bound, so that neighbouring data is not moved.
+ *  Pages already present are migrated.
+ *
+ *  \param addr start of the range
+ *  \param len length of the range (bytes)
+ *  \param node node number
+ *
+ *  \return \c 0, upon success (or if no page is entirely inside the range)
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int plBind (void *addr, size_t len, int node);
+
+#endif /* PLACEMENT_H_ */
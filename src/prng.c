@@ -0,0 +1,203 @@
+/**
+ *  \file prng.c (implementation file)
+ *
+ *  \brief Pseudo random number generation.
+ *
+ *  Each entity owns its generator (xoshiro256**), seeded from the seed chosen by the launcher and from
+ *  a stream number that identifies the entity, so that runs with the same seed are repeatable.
+ *
+ *  Defined operations:
+ *     \li initialization of the tables of the normal distribution
+ *     \li seeding of a generator
+ *     \li generation of 64 bit words, uniform reals and uniform integers in a range
+ *     \li generation of normally distributed reals (Ziggurat method)
+ *     \li generation of a pair of different integers in a range.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "prng.h"
+
+/** \brief number of layers of the ziggurat */
+#define  ZIGLAYERS      128
+/** \brief start of the tail of the ziggurat */
+#define  ZIGR           3.442619855899
+/** \brief area of each layer of the ziggurat */
+#define  ZIGV           9.91256303526217e-3
+
+/** \brief ziggurat tables: fast acceptance thresholds, layer widths and densities */
+static uint32_t kn[ZIGLAYERS];
+static double wn[ZIGLAYERS], fn[ZIGLAYERS];
+static bool zigReady = false;
+
+/* internal functions */
+
+static uint64_t splitmix64 (uint64_t *x)
+{
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotl (uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static void zigInit (void)
+{
+    const double m1 = 2147483648.0;
+    double dn = ZIGR, tn = dn, q;
+    int i;
+
+    q = ZIGV / exp (-0.5 * dn * dn);
+    kn[0] = (uint32_t) ((dn / q) * m1);
+    kn[1] = 0;
+    wn[0] = q / m1;
+    wn[ZIGLAYERS-1] = dn / m1;
+    fn[0] = 1.0;
+    fn[ZIGLAYERS-1] = exp (-0.5 * dn * dn);
+    for (i = ZIGLAYERS - 2; i >= 1; i--) {
+        dn = sqrt (-2.0 * log (ZIGV / dn + exp (-0.5 * dn * dn)));
+        kn[i+1] = (uint32_t) ((dn / tn) * m1);
+        tn = dn;
+        fn[i] = exp (-0.5 * dn * dn);
+        wn[i] = dn / m1;
+    }
+    zigReady = true;
+}
+
+/* external functions */
+
+/**
+ *  \brief Initialization of the tables of the normal distribution.
+ *
+ *  <tt>prngNormal</tt> initializes them on its first call; a program whose threads draw normal reals must call
+ *  this function before creating them.
+ */
+void prngInit (void)
+{
+    if (!zigReady) {
+        zigInit ();
+    }
+}
+
+/**
+ *  \brief Seeding of a generator.
+ *
+ *  Generators seeded with the same seed and different streams produce independent sequences.
+ *
+ *  \param g pointer to the generator
+ *  \param seed seed of the run
+ *  \param stream stream number (one per entity)
+ */
+void prngSeed (PRNG *g, uint64_t seed, uint64_t stream)
+{
+    uint64_t x = seed ^ splitmix64 (&stream);
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        g->s[i] = splitmix64 (&x);
+    }
+}
+
+/**
+ *  \brief Generation of a 64 bit word.
+ *
+ *  \param g pointer to the generator
+ *
+ *  \return uniformly distributed 64 bit word
+ */
+uint64_t prngNext (PRNG *g)
+{
+    uint64_t *s = g->s;
+    uint64_t r = rotl (s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl (s[3], 45);
+
+    return r;
+}
+
+/**
+ *  \brief Generation of a real uniformly distributed in ]0, 1[.
+ *
+ *  \param g pointer to the generator
+ */
+double prngUniform (PRNG *g)
+{
+    return ((prngNext (g) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ *  \brief Generation of an integer uniformly distributed in [0, n[.
+ *
+ *  \param g pointer to the generator
+ *  \param n range size (>= 1)
+ */
+unsigned int prngBelow (PRNG *g, unsigned int n)
+{
+    return (unsigned int) (((prngNext (g) >> 32) * (uint64_t) n) >> 32);
+}
+
+/**
+ *  \brief Generation of a real normally distributed with zero mean and unit standard deviation.
+ *
+ *  Ziggurat method with 128 layers (Marsaglia and Tsang).
+ *
+ *  \param g pointer to the generator
+ */
+double prngNormal (PRNG *g)
+{
+    int32_t hz;
+    uint32_t iz;
+    double x, y;
+
+    prngInit ();
+
+    for (;;) {
+        hz = (int32_t) (prngNext (g) >> 32);
+        iz = (uint32_t) hz & (ZIGLAYERS - 1);
+        if ((hz < 0 ? -(int64_t) hz : hz) < kn[iz]) {                                              /* fast path: inside layer */
+            return hz * wn[iz];
+        }
+        if (iz == 0) {                                                                          /* base layer: tail */
+            do {
+                x = -log (prngUniform (g)) / ZIGR;
+                y = -log (prngUniform (g));
+            } while (y + y < x * x);
+            return (hz > 0) ? ZIGR + x : -ZIGR - x;
+        }
+        x = hz * wn[iz];                                                                    /* wedge of the layer */
+        if (fn[iz] + prngUniform (g) * (fn[iz-1] - fn[iz]) < exp (-0.5 * x * x)) {
+            return x;
+        }
+    }
+}
+
+/**
+ *  \brief Generation of a pair of different integers, both uniformly distributed in [0, n[.
+ *
+ *  \param g pointer to the generator
+ *  \param n range size (>= 2)
+ *  \param pA pointer to the location where the first integer is stored
+ *  \param pB pointer to the location where the second integer is stored
+ */
+void prngPair (PRNG *g, unsigned int n, unsigned int *pA, unsigned int *pB)
+{
+    uint64_t r = prngNext (g);
+    unsigned int a = (unsigned int) (((r >> 32) * (uint64_t) n) >> 32);
+    unsigned int b = (unsigned int) (((r & 0xffffffffULL) * (uint64_t) (n - 1)) >> 32);
+
+    *pA = a;
+    *pB = b + (b >= a);
+}
@@ -0,0 +1,92 @@
+/**
+ *  \file prng.h (interface file)
+ *
+ *  \brief Pseudo random number generation.
+ *
+ *  Each entity owns its generator (xoshiro256**), seeded from the seed chosen by the launcher and from
+ *  a stream number that identifies the entity, so that runs with the same seed are repeatable.
+ *
+ *  Defined operations:
+ *     \li initialization of the tables of the normal distribution
+ *     \li seeding of a generator
+ *     \li generation of 64 bit words, uniform reals and uniform integers in a range
+ *     \li generation of normally distributed reals (Ziggurat method)
+ *     \li generation of a pair of different integers in a range.
+ */
+
+#ifndef PRNG_H_
+#define PRNG_H_
+
+#include <stdint.h>
+
+/**
+ *  \brief Definition of <em>generator state</em> data type.
+ */
+typedef struct {
+    /** \brief xoshiro256** state words */
+    uint64_t s[4];
+} PRNG;
+
+/**
+ *  \brief Initialization of the tables of the normal distribution.
+ *
+ *  <tt>prngNormal</tt> initializes them on its first call; a program whose threads draw normal reals must call
+ *  this function before creating them.
+ */
+extern void prngInit (void);
+
+/**
+ *  \brief Seeding of a generator.
+ *
+ *  Generators seeded with the same seed and different streams produce independent sequences.
+ *
+ *  \param g pointer to the generator
+ *  \param seed seed of the run
+ *  \param stream stream number (one per entity)
+ */
+extern void prngSeed (PRNG *g, uint64_t seed, uint64_t stream);
+
+/**
+ *  \brief Generation of a 64 bit word.
+ *
+ *  \param g pointer to the generator
+ *
+ *  \return uniformly distributed 64 bit word
+ */
+extern uint64_t prngNext (PRNG *g);
+
+/**
+ *  \brief Generation of a real uniformly distributed in ]0, 1[.
+ *
+ *  \param g pointer to the generator
+ */
+extern double prngUniform (PRNG *g);
+
+/**
+ *  \brief Generation of an integer uniformly distributed in [0, n[.
+ *
+ *  \param g pointer to the generator
+ *  \param n range size (>= 1)
+ */
+extern unsigned int prngBelow (PRNG *g, unsigned int n);
+
+/**
+ *  \brief Generation of a real normally distributed with zero mean and unit standard deviation.
+ *
+ *  Ziggurat method with 128 layers (Marsaglia and Tsang).
+ *
+ *  \param g pointer to the generator
+ */
+extern double prngNormal (PRNG *g);
+
+/**
+ *  \brief Generation of a pair of different integers, both uniformly distributed in [0, n[.
+ *
+ *  \param g pointer to the generator
+ *  \param n range size (>= 2)
+ *  \param pA pointer to the location where the first integer is stored
+ *  \param pB pointer to the location where the second integer is stored
+ */
+extern void prngPair (PRNG *g, unsigned int n, unsigned int *pA, unsigned int *pB);
+
+#endif /* PRNG_H_ */
@@ -17,6 +17,14 @@
 #define  NUMINGREDIENTS   3
 /** \brief total number of smokers */
 #define  NUMSMOKERS       3
+/** \brief maximum number of workers in the pool of each smoker */
+#define  MAXWORKERS       64
+/** \brief capacity of the order deque of each smoker worker */
+#define  DEQUESIZE        16
+/** \brief number of slots for the timestamps of the orders in flight */
+#define  ORDERSLOTS       16
+/** \brief number of state transitions kept in the event buffer of each entity */
+#define  EVENTCAP         4096
 
 /** \brief total number of orders to be generated by agent, each order has 2 different ingredients */
 #define  NUMORDERS        5
@@ -67,5 +75,27 @@
 /** \brief smoker is closing  */
 #define  CLOSING_S        3
 
+/* Benchmark stages: latency between two timestamps of an order */
+
+/** \brief from preparation of the ingredients by the agent to the watcher informing the smoker */
+#define  STAGE_MATCH      0
+/** \brief from the watcher informing the smoker to a worker starting to roll */
+#define  STAGE_DISPATCH   1
+/** \brief from start to end of rolling */
+#define  STAGE_ROLL       2
+/** \brief from preparation of the ingredients to end of rolling */
+#define  STAGE_TOTAL      3
+/** \brief number of benchmark stages */
+#define  NUMSTAGES        4
+
+/* Wake-up latencies: from the post of a semaphore to the waiting process running */
+
+/** \brief from the smoker completing the cigarette to the agent waking up */
+#define  WAKE_AGENT       0
+/** \brief from the watcher waking the workers of a smoker to a worker waking up */
+#define  WAKE_SMOKER      1
+/** \brief number of wake-up latencies */
+#define  NUMWAKES         2
+
 
 #endif /* PROBCONST_H_ */
@@ -19,14 +19,16 @@
 
 /**
  *  \brief Definition of <em>state of the intervening entities</em> data type.
+ *
+ *  Each state is written by its entity only (atomic release stores in the shared memory version).
  */
 typedef struct {
     /** \brief agent state */
     unsigned int agentStat;
     /** \brief watchers state */
     unsigned int watcherStat[NUMINGREDIENTS];
-    /** \brief smokers state */
-    unsigned int smokerStat[NUMSMOKERS];
+    /** \brief smokers state (one entry per worker, workers of the same smoker are contiguous) */
+    unsigned int smokerStat[NUMSMOKERS*MAXWORKERS];
 
 } STAT;
 
@@ -47,7 +49,10 @@ typedef struct
     /** \brief number of smokers */
     int nSmokers;
 
-    /** \brief flag used by agent to close factory */
+    /** \brief number of workers in the pool of each smoker */
+    int nWorkers;
+
+    /** \brief flag used by agent to close factory (atomic, written once) */
     bool closing;
 
     /** \brief inventory of ingredients */
@@ -56,10 +61,66 @@ typedef struct
     /** \brief number of ingredients already reserved by watcher */
     int reserved[NUMINGREDIENTS];
 
-    /** \brief number of cigarettes each smoker smoked */
-    int nCigarettes[NUMSMOKERS];
+    /** \brief number of cigarettes each smoker worker smoked (atomic, written by the worker only) */
+    int nCigarettes[NUMSMOKERS*MAXWORKERS];
 
 } FULL_STAT;
 
 
+/**
+ *  \brief Definition of <em>order timestamps</em> data type (monotonic clock, in ns).
+ */
+typedef struct {
+    /** \brief agent prepared the ingredients */
+    unsigned long long created;
+    /** \brief watcher informed the smoker */
+    unsigned long long matched;
+    /** \brief watcher woke the workers of the smoker (0 while it has not) */
+    unsigned long long posted;
+    /** \brief smoker worker started rolling */
+    unsigned long long rolling;
+    /** \brief smoker worker completed the cigarette */
+    unsigned long long done;
+
+} ORDER_TIMES;
+
+/**
+ *  \brief Definition of <em>state transition event</em> data type.
+ */
+typedef struct {
+    /** \brief time of the transition (monotonic clock, in ns) */
+    unsigned long long ts;
+    /** \brief new state */
+    unsigned int state;
+
+} EVENT;
+
+/**
+ *  \brief Definition of <em>event buffer</em> data type (ring with the latest transitions of an entity).
+ */
+typedef struct {
+    /** \brief number of transitions recorded so far */
+    unsigned int n;
+    /** \brief ring of transitions */
+    EVENT ev[EVENTCAP];
+
+} EVENT_BUF;
+
+/**
+ *  \brief Definition of <em>order deque</em> data type.
+ *
+ *  Ready orders are pushed by the watchers at the bottom of the deque of a smoker worker.
+ *  Both the owner and the idle workers of the same smoker that steal from it take from the top (oldest first).
+ */
+typedef struct {
+    /** \brief position of the oldest order (taking end) */
+    unsigned int top;
+    /** \brief position after the newest order (pushing end) */
+    unsigned int bottom;
+    /** \brief circular buffer of order ids */
+    unsigned int order[DEQUESIZE];
+
+} DEQUE;
+
+
 #endif /* PROBDATASTRUCT_H_ */
@@ -0,0 +1,873 @@
+/**
+ *  \file probEventSmokers.c (implementation file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  Synchronization based on eventfd channels and event loops.
+ *
+ *  Event loop engine: many independent factories run in a single process, each of their entities (agent,
+ *  watchers and smoker workers) being a state machine served by one of a few loop threads, instead of a
+ *  process blocked on a semaphore. The semaphores of a factory become notification channels (see notify.h):
+ *  <tt>ingredient[i]</tt>, <tt>wait2Ings[s]</tt> and <tt>waitCigarette</tt>, which a loop watches through its
+ *  epoll set for all the entities it serves that are waiting on them at once. The entities are dealt round
+ *  robin to the loops, so those of a factory are spread over the loops and notify each other across threads
+ *  (the workers of a smoker, on different loops, race for the units of its channel). The critical region of a
+ *  factory is a mutex, and the rolling and smoking durations are timers of the loops, so no loop ever blocks
+ *  on an entity.
+ *
+ *  Upon execution, the following parameters are accepted:
+ *    \li <tt>-K factories</tt>: number of factories (default 1; factory <tt>f</tt> uses seed <tt>seed+f</tt>, and
+ *        its log file gets the suffix <tt>.f</tt>)
+ *    \li <tt>-T loops</tt>: number of loop threads (default 1)
+ *    \li <tt>-w workers</tt>: number of workers in the pool of each smoker (default 1)
+ *    \li <tt>-s seed</tt>: seed of the pseudo random generators of all entities (default: time and pid based)
+ *    \li <tt>-n orders</tt>: number of orders to be generated by the agent of each factory (default NUMORDERS)
+ *    \li <tt>-x scale</tt>: factor applied to rolling and smoking durations (default 1, 0 disables them)
+ *    \li <tt>-b report</tt>: throughput (of all the factories) and per stage latency are written as JSON to the
+ *        report file
+ *    \li name of the logging file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "logging.h"
+#include "sharedDataSync.h"
+#include "stats.h"
+#include "prng.h"
+#include "timing.h"
+#include "notify.h"
+
+/** \brief channels of a factory: ingredient[i], wait2Ings[s] and waitCigarette */
+#define  CH_INGREDIENT(i)     (i)
+#define  CH_WAIT2INGS(s)      (NUMINGREDIENTS + (s))
+#define  CH_WAITCIGARETTE     (NUMINGREDIENTS + NUMSMOKERS)
+#define  NUMCHANS             (CH_WAITCIGARETTE + 1)
+
+/** \brief tag of the timer of a loop in its watch set */
+#define  TIMERTAG             UINT64_MAX
+
+/** \brief maximum number of factories */
+#define  MAXFACTORIES         65536
+
+/** \brief maximum number of loop threads */
+#define  MAXLOOPS             256
+
+/**
+ *  \brief Definition of <em>factory</em> data type.
+ */
+typedef struct {
+    /** \brief critical region protection */
+    pthread_mutex_t mutex;
+    /** \brief full state of the problem */
+    FULL_STAT fSt;
+    /** \brief notification channels (see CH_*) */
+    int chan[NUMCHANS];
+    /** \brief order waiting for a worker of each smoker (-1 if none) */
+    int pending[NUMSMOKERS];
+    /** \brief timestamps of the orders in flight (indexed by order id modulo ORDERSLOTS) */
+    ORDER_TIMES stamp[ORDERSLOTS];
+    /** \brief logging file name */
+    char nFic[64];
+
+} FACTORY;
+
+/**
+ *  \brief Definition of <em>entity</em> data type (only accessed by the loop that serves it).
+ */
+typedef struct {
+    /** \brief factory */
+    unsigned int f;
+    /** \brief slot in the factory (see ENT_*) */
+    unsigned int e;
+    /** \brief next entity of the loop waiting on the same channel (-1 if none) */
+    int next;
+    /** \brief order being served (agent and smoker workers) */
+    unsigned int order;
+    /** \brief state of a smoker worker while its timer runs (ROLLING or SMOKING) */
+    unsigned int phase;
+    /** \brief pseudo random generator (agent and smoker workers) */
+    PRNG rng;
+
+} ENTITY;
+
+/**
+ *  \brief Definition of <em>sleep</em> data type (a pending timer of a loop).
+ */
+typedef struct {
+    /** \brief end of the sleep (ns) */
+    uint64_t deadline;
+    /** \brief sleeping entity */
+    int x;
+
+} SLEEP;
+
+/**
+ *  \brief Definition of <em>loop</em> data type.
+ */
+typedef struct {
+    /** \brief thread */
+    pthread_t thread;
+    /** \brief index of the loop */
+    unsigned int id;
+    /** \brief watch set */
+    int set;
+    /** \brief timer of the sleeps */
+    int timer;
+    /** \brief first entity of the loop waiting on each channel of every factory (-1 if none) */
+    int *head;
+    /** \brief flag set while a channel of a factory is in the watch set */
+    bool *watched;
+    /** \brief pending sleeps (binary heap on the deadline) */
+    SLEEP *sleep;
+    /** \brief number of pending sleeps */
+    unsigned int nSleep;
+    /** \brief number of entities of the loop that did not close yet */
+    unsigned int nLive;
+    /** \brief latency of each benchmark stage (ns) */
+    HISTO latency[NUMSTAGES];
+    /** \brief time of preparation of the first order and of the last completed cigarette (ns) */
+    uint64_t firstCreated, lastDone;
+
+} LOOP;
+
+/** \brief names of the benchmark stages, as reported */
+static const char *stageName[NUMSTAGES] = { "match", "dispatch", "roll", "total" };
+
+/** \brief factories */
+static FACTORY *fact;
+
+/** \brief number of factories */
+static unsigned int nFact = 1;
+
+/** \brief entities of all the factories (factory f holds entities f*nEnt to f*nEnt+nEnt-1) */
+static ENTITY *ent;
+
+/** \brief number of entities of each factory */
+static unsigned int nEnt;
+
+/** \brief loops */
+static LOOP *loop;
+
+/** \brief number of loops */
+static unsigned int nLoops = 1;
+
+/** \brief factor applied to rolling and smoking durations */
+static double timeScale = 1.0;
+
+/** \brief start of operations of all loops */
+static pthread_barrier_t start;
+
+static void *loopMain (void *arg);
+
+static void wake (LOOP *L, unsigned int gc);
+
+static void waitOn (LOOP *L, int x, unsigned int c);
+
+static void sleepFor (LOOP *L, int x, double us);
+
+static void expire (LOOP *L);
+
+static void prepareIngredients (LOOP *L, int x);
+
+static void cigaretteDone (LOOP *L, int x);
+
+static void ingredientAvailable (LOOP *L, int x);
+
+static void ingredientsAvailable (LOOP *L, int x);
+
+static void rolled (LOOP *L, int x);
+
+static void smoked (LOOP *L, int x);
+
+static void post (FACTORY *F, unsigned int c, unsigned int n);
+
+static void writeReport (char nRep[], unsigned long long seed, double elapsed, HISTO latency[]);
+
+/**
+ *  \brief Main program.
+ *
+ *  Its role is to create the factories and their channels, to run the loop threads until every entity has
+ *  closed, to check that every factory completed its orders and to write the benchmark report.
+ */
+int main (int argc, char *argv[])
+{
+    char nFic[51];                                                                          /* logging file name */
+    int nWorkers = 1;                                                            /* number of workers of each smoker */
+    int nOrders = NUMORDERS;                                                       /* number of orders of each factory */
+    unsigned long long seed;                                                       /* seed of the random generators */
+    char nRep[256] = "";                                                             /* name of benchmark report */
+    char *tinp;                                                                     /* numerical parameters test flag */
+    int opt;                                                                                   /* command line option */
+    struct rlimit rl;
+    HISTO latency[NUMSTAGES];                                                   /* latencies of every loop */
+    uint64_t firstCreated = UINT64_MAX, lastDone = 0;
+    unsigned int f, x, l;
+    int failed = 0;                                         /* number of factories that did not complete */
+
+    /* getting options and log file name */
+    seed = ((unsigned long long) time (NULL) << 32) ^ (unsigned long long) getpid ();
+    while ((opt = getopt (argc, argv, "K:T:w:s:n:x:b:")) != -1) {
+        switch (opt) {
+            case 'K': nFact = (unsigned int) strtoul (optarg, &tinp, 0);
+                      if ((*tinp != '\0') || (nFact < 1) || (nFact > MAXFACTORIES)) {
+                          fprintf (stderr, "Number of factories must be between 1 and %d!\n", MAXFACTORIES);
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'T': nLoops = (unsigned int) strtoul (optarg, &tinp, 0);
+                      if ((*tinp != '\0') || (nLoops < 1) || (nLoops > MAXLOOPS)) {
+                          fprintf (stderr, "Number of loops must be between 1 and %d!\n", MAXLOOPS);
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'w': nWorkers = atoi (optarg);
+                      if ((nWorkers < 1) || (nWorkers > MAXWORKERS)) {
+                          fprintf (stderr, "Number of workers must be between 1 and %d!\n", MAXWORKERS);
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 's': seed = strtoull (optarg, &tinp, 0);
+                      if (*tinp != '\0') {
+                          fprintf (stderr, "Seed must be an unsigned integer!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'n': nOrders = (int) strtol (optarg, &tinp, 0);
+                      if ((*tinp != '\0') || (nOrders < 0)) {
+                          fprintf (stderr, "Number of orders must be a non negative integer!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'x': timeScale = strtod (optarg, &tinp);
+                      if ((*tinp != '\0') || (timeScale < 0.0)) {
+                          fprintf (stderr, "Time scale must be a non negative real!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'b': if (strlen (optarg) >= sizeof (nRep)) {
+                          fprintf (stderr, "Report file name is too long!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      strcpy (nRep, optarg);
+                      break;
+            default:  fprintf (stderr, "Usage: %s [-K factories] [-T loops] [-w workers] [-s seed] [-n orders] "
+                                       "[-x scale] [-b report] [logfile]\n", argv[0]);
+                      exit (EXIT_FAILURE);
+        }
+    }
+    if (optind < argc) {
+        strncpy (nFic, argv[optind], sizeof (nFic) - 1);
+        nFic[sizeof (nFic) - 1] = '\0';
+    }
+    else strcpy (nFic, "");
+
+    /* every factory holds NUMCHANS descriptors */
+    if ((getrlimit (RLIMIT_NOFILE, &rl) == 0) && (rl.rlim_cur < rl.rlim_max)) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit (RLIMIT_NOFILE, &rl);
+    }
+
+    /* creating the factories */
+    nEnt = ENT_SMOKER (NUMSMOKERS * nWorkers);
+    if (((fact = calloc (nFact, sizeof (FACTORY))) == NULL) || ((ent = calloc (nFact * nEnt, sizeof (ENTITY))) == NULL) ||
+        ((loop = calloc (nLoops, sizeof (LOOP))) == NULL)) {
+        perror ("error on allocating the factories");
+        exit (EXIT_FAILURE);
+    }
+    for (f = 0; f < nFact; f++) {
+        FACTORY *F = &fact[f];
+
+        pthread_mutex_init (&F->mutex, NULL);
+        for (int c = 0; c < NUMCHANS; c++) {
+            if ((F->chan[c] = nfChannel ()) == -1) {
+                perror ("error on creating the notification channels");
+                exit (EXIT_FAILURE);
+            }
+        }
+
+        /* initialize problem internal status */
+        F->fSt.st.agentStat = PREPARING;
+        for (int w = 0; w < NUMINGREDIENTS; w++) {
+            F->fSt.st.watcherStat[w] = WAITING_ING;
+        }
+        for (int s = 0; s < NUMSMOKERS * nWorkers; s++) {
+            F->fSt.st.smokerStat[s] = WAITING_2ING;
+        }
+        for (int s = 0; s < NUMSMOKERS; s++) {
+            F->pending[s] = -1;
+        }
+        F->fSt.nIngredients = NUMINGREDIENTS;
+        F->fSt.nSmokers     = NUMSMOKERS;
+        F->fSt.nWorkers     = nWorkers;
+        F->fSt.nOrders      = nOrders;
+
+        /* create log file */
+        strcpy (F->nFic, nFic);
+        if ((nFact > 1) && (nFic[0] != '\0')) {
+            sprintf (F->nFic + strlen (F->nFic), ".%u", f);
+        }
+        createLog (F->nFic, &F->fSt);
+        saveState (F->nFic, &F->fSt);
+
+        /* entities (random generator streams: 0 belongs to the agent, 1 + worker index to the smoker workers) */
+        for (unsigned int e = 0; e < nEnt; e++) {
+            ENTITY *E = &ent[f * nEnt + e];
+
+            E->f = f;
+            E->e = e;
+            E->next = -1;
+            if (e == ENT_AGENT) {
+                prngSeed (&E->rng, seed + f, 0);
+            }
+            else if (e >= (unsigned int) ENT_SMOKER (0)) {
+                prngSeed (&E->rng, seed + f, 1 + e - ENT_SMOKER (0));
+            }
+        }
+    }
+
+    /* creating the loops (the entities are dealt round robin) */
+    for (l = 0; l < nLoops; l++) {
+        LOOP *L = &loop[l];
+
+        L->id = l;
+        L->firstCreated = UINT64_MAX;
+        if (((L->head = malloc (nFact * NUMCHANS * sizeof (int))) == NULL) ||
+            ((L->watched = calloc (nFact * NUMCHANS, sizeof (bool))) == NULL) ||
+            ((L->sleep = malloc ((nFact * nEnt / nLoops + 1) * sizeof (SLEEP))) == NULL)) {
+            perror ("error on allocating the loops");
+            exit (EXIT_FAILURE);
+        }
+        memset (L->head, 0xff, nFact * NUMCHANS * sizeof (int));                               /* no waiters */
+        if (((L->set = nfSet ()) == -1) || ((L->timer = nfTimer ()) == -1) ||
+            (nfWatch (L->set, L->timer, TIMERTAG) == -1)) {
+            perror ("error on creating the watch set of a loop");
+            exit (EXIT_FAILURE);
+        }
+    }
+    for (x = 0; x < nFact * nEnt; x++) {
+        loop[x % nLoops].nLive += 1;
+    }
+
+    /* precise sleeps of the rolling and smoking durations (inherited by the loop threads) */
+    if (tmInit (0) == -1) {
+        perror ("error on setting the timer slack");
+        exit (EXIT_FAILURE);
+    }
+
+    /* running the loops (the tables of the normal distribution are filled before the threads draw from them) */
+    prngInit ();
+    pthread_barrier_init (&start, NULL, nLoops);
+    for (l = 0; l < nLoops; l++) {
+        if (pthread_create (&loop[l].thread, NULL, loopMain, &loop[l]) != 0) {
+            perror ("error on creating a loop thread");
+            exit (EXIT_FAILURE);
+        }
+    }
+    memset (latency, 0, sizeof (latency));
+    for (l = 0; l < nLoops; l++) {
+        if (pthread_join (loop[l].thread, NULL) != 0) {
+            perror ("error on waiting for a loop thread");
+            exit (EXIT_FAILURE);
+        }
+        for (int st = 0; st < NUMSTAGES; st++) {
+            histoMerge (&latency[st], &loop[l].latency[st]);
+        }
+        if (loop[l].firstCreated < firstCreated) firstCreated = loop[l].firstCreated;
+        if (loop[l].lastDone > lastDone) lastDone = loop[l].lastDone;
+    }
+
+    /* every factory must have smoked one cigarette per order */
+    for (f = 0; f < nFact; f++) {
+        int nCig = 0;
+
+        for (int s = 0; s < NUMSMOKERS * nWorkers; s++) {
+            nCig += fact[f].fSt.nCigarettes[s];
+        }
+        if (nCig != nOrders) {
+            fprintf (stderr, "factory %u smoked %d cigarettes for %d orders!\n", f, nCig, nOrders);
+            failed += 1;
+        }
+    }
+
+    if (nRep[0] != '\0') {
+        writeReport (nRep, seed, (lastDone > firstCreated) ? (lastDone - firstCreated) / 1e9 : 0.0, latency);
+    }
+
+    return (failed > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ *  \brief Loop thread.
+ *
+ *  The loop starts its entities (the agents prepare their first order, the watchers and the smoker workers
+ *  wait on their channels) and then serves the channels and the timer of its watch set until all its entities
+ *  have closed. The thread exits on failure.
+ *
+ *  \param arg pointer to the loop
+ */
+static void *loopMain (void *arg)
+{
+    LOOP *L = arg;
+    uint64_t tags[64];
+    int n;
+
+    pthread_barrier_wait (&start);
+    for (unsigned int x = L->id; x < nFact * nEnt; x += nLoops) {
+        if (ent[x].e == ENT_AGENT) {
+            prepareIngredients (L, (int) x);
+        }
+        else if (ent[x].e < (unsigned int) ENT_SMOKER (0)) {
+            waitOn (L, (int) x, CH_INGREDIENT (ent[x].e - ENT_WATCHER (0)));
+        }
+        else waitOn (L, (int) x, CH_WAIT2INGS ((ent[x].e - ENT_SMOKER (0)) / fact[ent[x].f].fSt.nWorkers));
+    }
+
+    while (L->nLive > 0) {
+        if ((n = nfWait (L->set, tags, 64, -1)) == -1) {
+            perror ("error on waiting on the watch set");
+            exit (EXIT_FAILURE);
+        }
+        for (int i = 0; i < n; i++) {
+            if (tags[i] == TIMERTAG) expire (L);
+            else wake (L, (unsigned int) tags[i]);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ *  \brief A channel of a factory has units.
+ *
+ *  One unit is taken for each entity of the loop waiting on the channel, while there are units left (another
+ *  loop may take them first), and the entity goes on. A channel without waiters is removed from the watch set.
+ *
+ *  \param L pointer to the loop
+ *  \param gc channel (factory * NUMCHANS + channel of the factory)
+ */
+static void wake (LOOP *L, unsigned int gc)
+{
+    FACTORY *F = &fact[gc / NUMCHANS];
+    unsigned int c = gc % NUMCHANS;
+    int x, r;
+
+    while ((x = L->head[gc]) >= 0) {
+        if ((r = nfTake (F->chan[c])) == -1) {
+            perror ("error on the take operation of a channel");
+            exit (EXIT_FAILURE);
+        }
+        if (r == 0) {
+            break;
+        }
+        L->head[gc] = ent[x].next;
+        if (c == CH_WAITCIGARETTE) cigaretteDone (L, x);
+        else if (c < CH_WAIT2INGS (0)) ingredientAvailable (L, x);
+        else ingredientsAvailable (L, x);
+    }
+    if ((L->head[gc] < 0) && L->watched[gc]) {
+        if (nfUnwatch (L->set, F->chan[c]) == -1) {
+            perror ("error on removing a channel from the watch set");
+            exit (EXIT_FAILURE);
+        }
+        L->watched[gc] = false;
+    }
+}
+
+/**
+ *  \brief An entity waits on a channel of its factory.
+ *
+ *  \param L pointer to the loop
+ *  \param x entity
+ *  \param c channel of the factory
+ */
+static void waitOn (LOOP *L, int x, unsigned int c)
+{
+    unsigned int gc = ent[x].f * NUMCHANS + c;
+
+    ent[x].next = L->head[gc];
+    L->head[gc] = x;
+    if (!L->watched[gc]) {
+        if (nfWatch (L->set, fact[ent[x].f].chan[c], gc) == -1) {
+            perror ("error on adding a channel to the watch set");
+            exit (EXIT_FAILURE);
+        }
+        L->watched[gc] = true;
+    }
+}
+
+/**
+ *  \brief A smoker worker sleeps.
+ *
+ *  The sleep is added to the heap of the loop, whose timer is armed for the earliest one. A sleep of zero
+ *  length ends at once.
+ *
+ *  \param L pointer to the loop
+ *  \param x entity
+ *  \param us length of the sleep (us)
+ */
+static void sleepFor (LOOP *L, int x, double us)
+{
+    unsigned int i;
+
+    if (us <= 0) {
+        if (ent[x].phase == ROLLING) rolled (L, x);
+        else smoked (L, x);
+        return;
+    }
+    i = L->nSleep++;
+    L->sleep[i].deadline = nowNs () + (uint64_t) (us * 1000.0);
+    L->sleep[i].x = x;
+    while ((i > 0) && (L->sleep[(i - 1) / 2].deadline > L->sleep[i].deadline)) {              /* sift up */
+        SLEEP t = L->sleep[i];
+
+        L->sleep[i] = L->sleep[(i - 1) / 2];
+        L->sleep[(i - 1) / 2] = t;
+        i = (i - 1) / 2;
+    }
+    if ((i == 0) && (nfArm (L->timer, L->sleep[0].deadline) == -1)) {
+        perror ("error on arming the timer of a loop");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief The timer of a loop expired.
+ *
+ *  Every sleep that is over is ended and the timer is armed for the next one.
+ *
+ *  \param L pointer to the loop
+ */
+static void expire (LOOP *L)
+{
+    uint64_t now;
+    int x;
+
+    if (nfExpired (L->timer) == -1) {
+        perror ("error on reading the timer of a loop");
+        exit (EXIT_FAILURE);
+    }
+    now = nowNs ();
+    while ((L->nSleep > 0) && (L->sleep[0].deadline <= now)) {
+        unsigned int i = 0, k;
+
+        x = L->sleep[0].x;
+        L->sleep[0] = L->sleep[--L->nSleep];
+        while ((k = 2 * i + 1) < L->nSleep) {                                                       /* sift down */
+            if ((k + 1 < L->nSleep) && (L->sleep[k + 1].deadline < L->sleep[k].deadline)) {
+                k += 1;
+            }
+            if (L->sleep[i].deadline <= L->sleep[k].deadline) {
+                break;
+            }
+            SLEEP t = L->sleep[i];
+            L->sleep[i] = L->sleep[k];
+            L->sleep[k] = t;
+            i = k;
+        }
+        if (ent[x].phase == ROLLING) rolled (L, x);                    /* may add sleeps, the loop goes on */
+        else smoked (L, x);
+    }
+    if (nfArm (L->timer, (L->nSleep > 0) ? L->sleep[0].deadline : 0) == -1) {
+        perror ("error on arming the timer of a loop");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief agent prepares 2 ingredients
+ *
+ *  The agent updates state, selects a pack of 2 different ingredients, notifies the watchers of both and
+ *  waits for the cigarette.
+ *
+ *  \param L pointer to the loop
+ *  \param x entity
+ */
+static void prepareIngredients (LOOP *L, int x)
+{
+    ENTITY *E = &ent[x];
+    FACTORY *F = &fact[E->f];
+    unsigned int ing, ing2;
+    uint64_t t;
+
+    prngPair (&E->rng, F->fSt.nIngredients, &ing, &ing2);                  /* pack of 2 different ingredients */
+
+    pthread_mutex_lock (&F->mutex);                                                         /* enter critical region */
+    F->fSt.st.agentStat = PREPARING;
+    F->fSt.ingredients[ing] += 1;
+    F->fSt.ingredients[ing2] += 1;
+    F->stamp[E->order % ORDERSLOTS].created = t = nowNs ();
+    saveState (F->nFic, &F->fSt);
+    pthread_mutex_unlock (&F->mutex);                                                        /* exit critical region */
+    if (t < L->firstCreated) {
+        L->firstCreated = t;
+    }
+
+    post (F, CH_INGREDIENT (ing), 1);
+    post (F, CH_INGREDIENT (ing2), 1);
+
+    pthread_mutex_lock (&F->mutex);                                                         /* enter critical region */
+    F->fSt.st.agentStat = WAITING_CIG;
+    saveState (F->nFic, &F->fSt);
+    pthread_mutex_unlock (&F->mutex);                                                        /* exit critical region */
+    waitOn (L, x, CH_WAITCIGARETTE);
+}
+
+/**
+ *  \brief agent is notified of the cigarette
+ *
+ *  The agent prepares the next order or, after the last one, closes the factory: it updates state and wakes
+ *  every watcher and every worker of every smoker.
+ *
+ *  \param L pointer to the loop
+ *  \param x entity
+ */
+static void cigaretteDone (LOOP *L, int x)
+{
+    ENTITY *E = &ent[x];
+    FACTORY *F = &fact[E->f];
+
+    if ((int) ++E->order < F->fSt.nOrders) {
+        prepareIngredients (L, x);
+        return;
+    }
+
+    pthread_mutex_lock (&F->mutex);                                                         /* enter critical region */
+    F->fSt.st.agentStat = CLOSING_A;
+    F->fSt.closing = true;
+    saveState (F->nFic, &F->fSt);
+    pthread_mutex_unlock (&F->mutex);                                                        /* exit critical region */
+    for (int i = 0; i < F->fSt.nIngredients; i++) {
+        post (F, CH_INGREDIENT (i), 1);
+    }
+    for (int s = 0; s < F->fSt.nSmokers; s++) {
+        post (F, CH_WAIT2INGS (s), (unsigned int) F->fSt.nWorkers);
+    }
+    L->nLive -= 1;
+}
+
+/**
+ *  \brief watcher gets its ingredient
+ *
+ *  The watcher updates state and reserves the ingredient; if the smoker holding the third ingredient may
+ *  roll, the order is left for its workers and the smoker is notified. The watcher then waits again, unless
+ *  the factory is closing.
+ *
+ *  \param L pointer to the loop
+ *  \param x entity
+ */
+static void ingredientAvailable (LOOP *L, int x)
+{
+    ENTITY *E = &ent[x];
+    FACTORY *F = &fact[E->f];
+    int id = (int) (E->e - ENT_WATCHER (0));
+    int nReserved = 0, smoker = -1;
+
+    pthread_mutex_lock (&F->mutex);                                                         /* enter critical region */
+    if (F->fSt.closing) {
+        F->fSt.st.watcherStat[id] = CLOSING_W;
+        saveState (F->nFic, &F->fSt);
+        pthread_mutex_unlock (&F->mutex);                                                    /* exit critical region */
+        L->nLive -= 1;
+        return;
+    }
+    F->fSt.st.watcherStat[id] = UPDATING;
+    F->fSt.reserved[id] += 1;
+    for (int i = 0; i < F->fSt.nIngredients; i++) {
+        if (F->fSt.reserved[i] > 0) nReserved += 1;
+        else smoker = i;
+    }
+    saveState (F->nFic, &F->fSt);
+    if (nReserved == 2) {
+        unsigned int order = ent[E->f * nEnt + ENT_AGENT].order;             /* stable until the cigarette */
+
+        F->fSt.st.watcherStat[id] = INFORMING;
+        for (int i = 0; i < F->fSt.nIngredients; i++) {
+            F->fSt.reserved[i] = 0;
+        }
+        if (F->pending[smoker] >= 0) {
+            fprintf (stderr, "order overflow of smoker %d (factory %u)!\n", smoker, E->f);
+            exit (EXIT_FAILURE);
+        }
+        F->pending[smoker] = (int) order;
+        F->stamp[order % ORDERSLOTS].matched = nowNs ();
+        saveState (F->nFic, &F->fSt);
+    }
+    else smoker = -1;
+    F->fSt.st.watcherStat[id] = WAITING_ING;
+    saveState (F->nFic, &F->fSt);
+    pthread_mutex_unlock (&F->mutex);                                                        /* exit critical region */
+
+    if (smoker >= 0) {
+        post (F, CH_WAIT2INGS (smoker), 1);
+    }
+    waitOn (L, x, CH_INGREDIENT (id));
+}
+
+/**
+ *  \brief smoker worker is notified of the ingredients
+ *
+ *  The worker takes the order left for its smoker, updates state and starts rolling; if the factory is
+ *  closing, it updates state and closes.
+ *
+ *  \param L pointer to the loop
+ *  \param x entity
+ */
+static void ingredientsAvailable (LOOP *L, int x)
+{
+    ENTITY *E = &ent[x];
+    FACTORY *F = &fact[E->f];
+    int id = (int) (E->e - ENT_SMOKER (0));
+    int s = id / F->fSt.nWorkers;
+
+    pthread_mutex_lock (&F->mutex);                                                         /* enter critical region */
+    if (F->pending[s] < 0) {
+        if (!F->fSt.closing) {
+            fprintf (stderr, "woken up without pending orders (factory %u, smoker worker %d)\n", E->f, id);
+            exit (EXIT_FAILURE);
+        }
+        F->fSt.st.smokerStat[id] = CLOSING_S;
+        saveState (F->nFic, &F->fSt);
+        pthread_mutex_unlock (&F->mutex);                                                    /* exit critical region */
+        L->nLive -= 1;
+        return;
+    }
+    E->order = (unsigned int) F->pending[s];
+    F->pending[s] = -1;
+    F->fSt.st.smokerStat[id] = ROLLING;
+    for (int i = 0; i < NUMINGREDIENTS; i++) {
+        F->fSt.ingredients[i] = 0;
+    }
+    F->stamp[E->order % ORDERSLOTS].rolling = nowNs ();
+    saveState (F->nFic, &F->fSt);
+    pthread_mutex_unlock (&F->mutex);                                                        /* exit critical region */
+
+    E->phase = ROLLING;
+    sleepFor (L, x, (100.0 + prngNormal (&E->rng) * 30.0) * timeScale);
+}
+
+/**
+ *  \brief smoker worker completed the cigarette
+ *
+ *  The worker notifies the agent, updates state and the number of cigarettes and starts smoking.
+ *
+ *  \param L pointer to the loop
+ *  \param x entity
+ */
+static void rolled (LOOP *L, int x)
+{
+    ENTITY *E = &ent[x];
+    FACTORY *F = &fact[E->f];
+    int id = (int) (E->e - ENT_SMOKER (0));
+    ORDER_TIMES *t = &F->stamp[E->order % ORDERSLOTS];
+    uint64_t stageNs[NUMSTAGES];
+
+    /* the slot of the order can not be reused before the agent is notified */
+    t->done = nowNs ();
+    stageNs[STAGE_MATCH]    = t->matched - t->created;
+    stageNs[STAGE_DISPATCH] = t->rolling - t->matched;
+    stageNs[STAGE_ROLL]     = t->done - t->rolling;
+    stageNs[STAGE_TOTAL]    = t->done - t->created;
+    if (t->done > L->lastDone) {
+        L->lastDone = t->done;
+    }
+    for (int st = 0; st < NUMSTAGES; st++) {
+        histoAdd (&L->latency[st], stageNs[st]);
+    }
+    post (F, CH_WAITCIGARETTE, 1);
+
+    pthread_mutex_lock (&F->mutex);                                                         /* enter critical region */
+    F->fSt.st.smokerStat[id] = SMOKING;
+    F->fSt.nCigarettes[id] += 1;
+    saveState (F->nFic, &F->fSt);
+    pthread_mutex_unlock (&F->mutex);                                                        /* exit critical region */
+
+    E->phase = SMOKING;
+    sleepFor (L, x, (100.0 + prngNormal (&E->rng) * 30.0) * timeScale);
+}
+
+/**
+ *  \brief smoker worker finished smoking
+ *
+ *  The worker updates state and waits for the ingredients again.
+ *
+ *  \param L pointer to the loop
+ *  \param x entity
+ */
+static void smoked (LOOP *L, int x)
+{
+    ENTITY *E = &ent[x];
+    FACTORY *F = &fact[E->f];
+    int id = (int) (E->e - ENT_SMOKER (0));
+
+    pthread_mutex_lock (&F->mutex);                                                         /* enter critical region */
+    F->fSt.st.smokerStat[id] = WAITING_2ING;
+    saveState (F->nFic, &F->fSt);
+    pthread_mutex_unlock (&F->mutex);                                                        /* exit critical region */
+
+    waitOn (L, x, CH_WAIT2INGS (id / F->fSt.nWorkers));
+}
+
+/**
+ *  \brief Post operation on a channel of a factory.
+ *
+ *  The thread exits on failure.
+ *
+ *  \param F pointer to the factory
+ *  \param c channel of the factory
+ *  \param n number of units
+ */
+static void post (FACTORY *F, unsigned int c, unsigned int n)
+{
+    if (nfPost (F->chan[c], n) == -1) {
+        perror ("error on the post operation of a channel");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief Writing the benchmark report.
+ *
+ *  A single JSON object holds the configuration of the run, the throughput (orders per second of all the
+ *  factories, from the preparation of the first order to the completion of the last cigarette) and the latency
+ *  histogram of each benchmark stage, in nanoseconds.
+ *
+ *  \param nRep name of the report file
+ *  \param seed seed of the random generators
+ *  \param elapsed elapsed time (s)
+ *  \param latency latency of each benchmark stage
+ */
+static void writeReport (char nRep[], unsigned long long seed, double elapsed, HISTO latency[])
+{
+    FILE *fic;                                                                                      /* file descriptor */
+    FULL_STAT *fSt = &fact[0].fSt;
+
+    if ((fic = fopen (nRep, "w")) == NULL) {
+        perror ("error on opening the report file");
+        exit (EXIT_FAILURE);
+    }
+    fprintf (fic, "{\"engine\":\"eventloop\",\"factories\":%u,\"loops\":%u,\"entities\":%u,\"orders\":%d,"
+                  "\"smokers\":%d,\"workers\":%d,\"timeScale\":%g,\"seed\":%llu,\"elapsed_s\":%.6f,"
+                  "\"orders_per_s\":%.1f,\"latency_ns\":{",
+             nFact, nLoops, nFact * nEnt, fSt->nOrders, fSt->nSmokers, fSt->nWorkers, timeScale, seed, elapsed,
+             (elapsed > 0.0) ? (double) nFact * fSt->nOrders / elapsed : 0.0);
+    for (int st = 0; st < NUMSTAGES; st++) {
+        fprintf (fic, "%s\"%s\":", (st > 0) ? "," : "", stageName[st]);
+        histoPrintJson (fic, &latency[st]);
+    }
+    fprintf (fic, "}}\n");
+
+    if (fclose (fic) == EOF) {
+        perror ("error on closing the report file");
+        exit (EXIT_FAILURE);
+    }
+}
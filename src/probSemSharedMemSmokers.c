@@ -8,7 +8,41 @@
  *
  *  Generator process of the intervening entities.
  *
- *  Upon execution, one parameter is requested:
+ *  Upon execution, the following parameters are accepted:
+ *    \li <tt>-w workers</tt>: number of workers in the pool of each smoker (default 1)
+ *    \li <tt>-m</tt>: a single matcher process replaces the watcher processes
+ *    \li <tt>-s seed</tt>: seed of the pseudo random generators of all entities (default: time and pid based)
+ *    \li <tt>-t trace</tt>: the agent replays the orders (and the smokers the durations) of a trace file
+ *    \li <tt>-n orders</tt>: number of orders to be generated by the agent (default NUMORDERS)
+ *    \li <tt>-x scale</tt>: factor applied to rolling and smoking durations (default 1, 0 disables them)
+ *    \li <tt>-b report</tt>: throughput and per stage latency are written as JSON to the report file
+ *    \li <tt>-e events</tt>: state timelines of all entities are exported to the events file (Chrome Trace Event JSON)
+ *    \li <tt>-k key</tt>: access key to the shared memory and semaphore set (default: generated from the directory)
+ *    \li <tt>-d deadline</tt>: watchdog, if no entity completes a semaphore operation for <tt>deadline</tt> seconds
+ *        the state of every entity and the semaphore it is blocked on are dumped and the simulation is torn down
+ *    \li <tt>-f</tt>: (multi-call binary only) the entities are forked without exec, straight into their entry point
+ *    \li <tt>-a class=cpus</tt>: the entities of a class (agent, watcher, smoker or matcher) are pinned to a CPU list
+ *        (<tt>0-3,8</tt>) or to the CPUs of a NUMA node (<tt>node1</tt>); may be repeated
+ *    \li <tt>-M node</tt>: the memory of the shared region is bound to a NUMA node
+ *    \li <tt>-L</tt>: the per entity data (random generators and, when the transitions are recorded with <tt>-e</tt>,
+ *        state transition buffers) of each placed class is bound to the node of its CPUs (the generators only on
+ *        the pages that no other class shares, so <tt>-e</tt> should be given too)
+ *    \li <tt>-K factories</tt>: multi-tenant mode, as many independent factories as given run in a single shared
+ *        region and semaphore set (factory <tt>f</tt> uses seed <tt>seed+f</tt>, and its log, error, report and
+ *        events files get the suffix <tt>.f</tt>)
+ *    \li <tt>-c checkpoint</tt>: every <tt>-i</tt> orders (default CKPTEVERY) the agent saves a checkpoint of the
+ *        run in the given file (with suffix <tt>.f</tt> in multi-tenant mode)
+ *    \li <tt>-R</tt>: the run is resumed from the latest checkpoint in the file given by <tt>-c</tt> (the number of
+ *        orders, workers, matcher and trace options must be those of the checkpointed run; its seed is reused)
+ *    \li <tt>-u spin</tt>: each rolling and smoking sleep ends with a busy wait of <tt>spin</tt> microseconds, for
+ *        precision (the error of the sleeps is reported)
+ *    \li <tt>-r class=policy:prio</tt>: real-time mode, the entities of a class run with the <tt>fifo</tt> or
+ *        <tt>rr</tt> scheduling policy and the given priority (may be repeated), and every entity locks and
+ *        pre-touches its memory before operations start (the wake-up latencies are reported in any mode)
+ *    \li <tt>-p seed</tt>: stress mode, the semaphore operations of every entity are perturbed with seeded random
+ *        yields and short sleeps
+ *    \li <tt>-G</tt>: global lock, every lock domain of the shared data is protected by the single mutex (for
+ *        comparison with the default sharded locking)
  *    \li name of the logging file.
  *
  *  \author Nuno Lau - December 2019
@@ -23,6 +57,12 @@
 #include <sys/ipc.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
+#include <limits.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <spawn.h>
 
 #include "probConst.h"
 #include "probDataStruct.h"
@@ -30,6 +70,15 @@
 #include "sharedDataSync.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
+#include "stats.h"
+#include "eventTrace.h"
+#include "trace.h"
+#include "perfCounters.h"
+#include "entityMain.h"
+#include "placement.h"
+#include "arena.h"
+#include "checkpoint.h"
+#include "realtime.h"
 
 /** \brief name of agent program */
 #define   AGENT               "./agent"
@@ -40,169 +89,588 @@
 /** \brief name of smoker program */
 #define   SMOKER              "./smoker"
 
+/** \brief name of matcher program */
+#define   MATCHER             "./matcher"
+
+/** \brief alignment of the shared data in the arena (page, so that its pages can be bound to nodes) */
+#define   SHALIGN             4096
+
+/** \brief maximum number of factories in the shared region */
+#define   MAXFACTORIES        64
+
+/** \brief period of the progress checks of the watchdog (ms) */
+#define   WATCHDOGTICK        20
+
+/** \brief entity classes, as placed by <tt>-a</tt> and scheduled by <tt>-r</tt> */
+#define   PL_AGENT            0
+#define   PL_WATCHER          1
+#define   PL_SMOKER           2
+#define   PL_MATCHER          3
+#define   NUMCLASSES          4
+
+/** \brief names of the entity classes */
+static const char *className[NUMCLASSES] = { "agent", "watcher", "smoker", "matcher" };
+
+/** \brief names of the benchmark stages, as reported */
+static const char *stageName[NUMSTAGES] = { "match", "dispatch", "roll", "total" };
+
+/** \brief names of the wake-up latencies, as reported */
+static const char *wakeName[NUMWAKES] = { "agent", "smoker" };
+
+/** \brief environment of the launcher, inherited by the entities */
+extern char **environ;
+
+#ifdef MULTICALL
+/** \brief image of the multi-call binary, run by every entity */
+#define   SELF                "/proc/self/exe"
+
+/** \brief flag set when the entities are forked without exec */
+static bool forkOnly = false;
+#endif
+
+static void writeReport (char nRep[], SHARED_DATA *sh, unsigned int nFact, double launchMs, double readyMs);
+
+static char *factoryName (char name[], unsigned int f, unsigned int nFact);
+
+static int ckptPrepare (SHARED_DATA *sh, RNG_SLOT rng[], char nCk[], bool resume);
+
+static void dumpEntities (SHARED_DATA *sh, int pidAG, int pidWT[], int pidSM[]);
+
+static void killEntities (SHARED_DATA *sh, int pidAG, int pidWT[], int pidSM[]);
+
+static int spawn (char *path, char *args[], const PLACEMENT *pl, const RT_SCHED *rt);
+
+static int placeClass (const char *name, size_t len);
+
+static void placeLocal (EVENT_BUF ev[], RNG_SLOT rng[], PLACEMENT place[], int nWorkers, bool matcher);
+
 
 /**
- *  \brief Main program.
+ *  \brief Entry point of the launcher (main program of its stand-alone executable).
  *
  *  Its role is starting the simulation by generating the intervening entities processes (agent, watcher and smokers)
  *  and waiting for their termination.
  */
-int main (int argc, char *argv[])
+int launcherMain (int argc, char *argv[])
 {
     char nFic[51];                                                                              /*name of logging file */
-    char nFicErr[] = "error_        ";                                                     /* base name of error files */
+    char nFicF[64];                                                                 /* name of logging file of a factory */
+    char nFicErr[32] = "error_";                                                           /* base name of error files */
+    char nEvF[272];                                                                  /* name of events file of a factory */
     int shmid,                                                                      /* shared memory access identifier */
         semgid;                                                                     /* semaphore set access identifier */
-    unsigned int  m;                                                                             /* counting variables */
-    SHARED_DATA *sh;                                                                /* pointer to shared memory region */
-    int pidAG,                                                                             /* agent process identifier */
-        pidWT[NUMINGREDIENTS],                                                    /* watchers process identifier array */
-        pidSM[NUMSMOKERS];                                                         /* smokers process identifier array */
-    int key;                                                           /*access key to shared memory and semaphore set */
-    char num[2][12];                                                     /* numeric value conversion (up to 10 digits) */
+    unsigned int  m, e, f;                                                                       /* counting variables */
+    void *arena;                                                                     /* pointer to shared memory region */
+    size_t size;                                                                          /* size of the shared region */
+    RNG_SLOT *rngBase;                                            /* pointer to the random generators region */
+    EVENT_BUF *evBase = NULL,                 /* pointer to the state transition buffers region (NULL: not recorded) */
+              *ev;                                                                  /* buffers of a factory in it */
+    SHARED_DATA *shBase,                                                          /* pointer to the shared data region */
+                *sh;                                                                    /* pointer to a factory in it */
+    unsigned int nFact = 1;                                                        /* number of factories in the region */
+    int pidAG[MAXFACTORIES],                                                               /* agent process identifier */
+        pidWT[MAXFACTORIES][NUMINGREDIENTS],                                      /* watchers process identifier array */
+        pidSM[MAXFACTORIES][NUMSMOKERS*MAXWORKERS];                                /* smokers process identifier array */
+    int nWorkers = 1;                                                            /* number of workers of each smoker */
+    bool matcher = false;                                                   /* a matcher replaces the watchers */
+    int nWatchers;                                                           /* number of watcher processes */
+    int opt;                                                                                   /* command line option */
+    unsigned long long seed;                                                       /* seed of the random generators */
+    char *tinp;                                                                     /* numerical parameters test flag */
+    char nTrace[256] = "";                                                                   /* name of trace file */
+    int nOrders = NUMORDERS;                                                       /* number of orders to be generated */
+    TRACE trc;                                                                                       /* mapped trace */
+    double timeScale = 1.0;                                           /* factor applied to rolling/smoking times */
+    double spin = 0.0;                                          /* busy wait at the end of each sleep (us) */
+    HISTO sleepErr;                                                    /* error of the sleeps of every factory */
+    char nRep[256] = "";                                                             /* name of benchmark report */
+    char nEv[256] = "";                                                                   /* name of events file */
+    int key = -1;                                                      /*access key to shared memory and semaphore set */
+    unsigned long long stress = 0;                               /* seed of the schedule perturbation (0: none) */
+    int failed = 0;                                                   /* number of entities that did not succeed */
+    PLACEMENT place[NUMCLASSES];                                               /* placement of each entity class */
+    int memNode = -1;                                        /* node of the shared region (-1: first touch) */
+    bool local = false;                                  /* flag set when per entity data follows its owner */
+    RT_SCHED sched[NUMCLASSES];                                  /* real-time scheduling of each entity class */
+    bool rtMode = false;                                   /* flag set when the entities lock their memory */
+    bool global = false;                                    /* flag set when every lock domain uses the mutex */
+    int c;
+    char nCk[256] = "";                                                              /* name of checkpoint file */
+    unsigned int ckptEvery = CKPTEVERY;                                           /* orders between checkpoints */
+    bool resume = false;                                          /* flag set when the run resumes a checkpoint */
+    double deadline = 0.0;                                   /* watchdog deadline (s), 0 disables the watchdog */
+    bool wedged = false;                                                /* flag set when the watchdog fires */
+    unsigned long long beats, lastBeats = 0;                                     /* sum of the heartbeats */
+    uint64_t tProgress;                                                         /* time of the last progress */
+    uint64_t tLaunch, tSpawned, tReady = 0;             /* start of the launch, end of the spawns, all entities ready */
+    unsigned int nProc;                                                /* number of intervening processes */
+    char num[2][24];                                        /* numeric value conversion (key/factory, up to 21 chars) */
     int status,                                                                                    /* execution status */
         info;                                                                                               /* info id */
 
-    /* getting log file name */
-    if(argc==2) {
-        strcpy(nFic, argv[1]);
+    /* getting options and log file name */
+    memset (place, 0, sizeof (place));
+    memset (sched, 0, sizeof (sched));
+    seed = ((unsigned long long) time (NULL) << 32) ^ (unsigned long long) getpid ();
+    while ((opt = getopt (argc, argv, "w:ms:t:n:x:b:e:k:p:d:fa:M:LK:c:i:Ru:r:G")) != -1) {
+        switch (opt) {
+            case 'w': nWorkers = atoi (optarg);
+                      if ((nWorkers < 1) || (nWorkers > MAXWORKERS)) {
+                          fprintf (stderr, "Number of workers must be between 1 and %d!\n", MAXWORKERS);
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'm': matcher = true;
+                      break;
+            case 's': seed = strtoull (optarg, &tinp, 0);
+                      if (*tinp != '\0') {
+                          fprintf (stderr, "Seed must be an unsigned integer!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 't': if (strlen (optarg) >= sizeof (nTrace)) {
+                          fprintf (stderr, "Trace file name is too long!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      strcpy (nTrace, optarg);
+                      break;
+            case 'n': nOrders = (int) strtol (optarg, &tinp, 0);
+                      if ((*tinp != '\0') || (nOrders < 0)) {
+                          fprintf (stderr, "Number of orders must be a non negative integer!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'x': timeScale = strtod (optarg, &tinp);
+                      if ((*tinp != '\0') || (timeScale < 0.0)) {
+                          fprintf (stderr, "Time scale must be a non negative real!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'b': if (strlen (optarg) >= sizeof (nRep)) {
+                          fprintf (stderr, "Report file name is too long!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      strcpy (nRep, optarg);
+                      break;
+            case 'e': if (strlen (optarg) >= sizeof (nEv)) {
+                          fprintf (stderr, "Events file name is too long!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      strcpy (nEv, optarg);
+                      break;
+            case 'k': key = (int) strtol (optarg, &tinp, 0);
+                      if ((*tinp != '\0') || (key <= 0)) {
+                          fprintf (stderr, "Key must be a positive integer!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'p': stress = strtoull (optarg, &tinp, 0);
+                      if (*tinp != '\0') {
+                          fprintf (stderr, "Perturbation seed must be an unsigned integer!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'd': deadline = strtod (optarg, &tinp);
+                      if ((*tinp != '\0') || (deadline < 0.0)) {
+                          fprintf (stderr, "Watchdog deadline must be a non negative real!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'f':
+#ifdef MULTICALL
+                      forkOnly = true;
+                      break;
+#else
+                      fprintf (stderr, "Fork without exec is only available in the multi-call binary!\n");
+                      exit (EXIT_FAILURE);
+#endif
+            case 'a': if (((tinp = strchr (optarg, '=')) == NULL) || ((c = placeClass (optarg, tinp - optarg)) == -1) ||
+                          (plParse (tinp + 1, &place[c]) == -1)) {
+                          fprintf (stderr, "Placement must be agent|watcher|smoker|matcher=cpu-list|nodeN!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'M': memNode = (int) strtol (optarg, &tinp, 0);
+                      if ((*tinp != '\0') || (memNode < 0)) {
+                          fprintf (stderr, "Memory node must be a non negative integer!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'L': local = true;
+                      break;
+            case 'K': nFact = (unsigned int) strtoul (optarg, &tinp, 0);
+                      if ((*tinp != '\0') || (nFact < 1) || (nFact > MAXFACTORIES)) {
+                          fprintf (stderr, "Number of factories must be between 1 and %d!\n", MAXFACTORIES);
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'c': if (strlen (optarg) >= sizeof (nCk) - 4) {
+                          fprintf (stderr, "Checkpoint file name is too long!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      strcpy (nCk, optarg);
+                      break;
+            case 'i': ckptEvery = (unsigned int) strtoul (optarg, &tinp, 0);
+                      if ((*tinp != '\0') || (ckptEvery == 0)) {
+                          fprintf (stderr, "Checkpoint interval must be a positive integer!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'R': resume = true;
+                      break;
+            case 'u': spin = strtod (optarg, &tinp);
+                      if ((*tinp != '\0') || (spin < 0.0) || (spin > 1e6)) {
+                          fprintf (stderr, "Spin must be a real between 0 and 1000000!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'r': if (((tinp = strchr (optarg, '=')) == NULL) || ((c = placeClass (optarg, tinp - optarg)) == -1) ||
+                          (rtParse (tinp + 1, &sched[c]) == -1)) {
+                          fprintf (stderr, "Scheduling must be agent|watcher|smoker|matcher=fifo|rr:priority!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      rtMode = true;
+                      break;
+            case 'G': global = true;
+                      break;
+            default:  fprintf (stderr, "Usage: %s [-w workers] [-m] [-s seed] [-t trace] [-n orders] [-x scale] "
+                                       "[-b report] [-e events] [-k key] [-p perturbation-seed] [-d deadline] [-f] "
+                                       "[-a class=cpus] [-M node] [-L] [-K factories] [-c checkpoint] [-i interval] [-R] "
+                                       "[-u spin] [-r class=policy:prio] [-G] [logfile]\n", argv[0]);
+                      exit (EXIT_FAILURE);
+        }
+    }
+    if (optind < argc) {
+        strncpy(nFic, argv[optind], sizeof (nFic) - 1);
+        nFic[sizeof (nFic) - 1] = '\0';
     }
     else strcpy(nFic, "");
+    if (resume && (nCk[0] == '\0')) {
+        fprintf (stderr, "Resuming requires a checkpoint file!\n");
+        exit (EXIT_FAILURE);
+    }
+    if (local && (nEv[0] == '\0')) {
+        fprintf (stderr, "warning: without -e, -L binds only the pages of random generators no other class shares\n");
+    }
+
+    /* validating the trace file: the number of orders is given by the trace */
+    if (nTrace[0] != '\0') {
+        if (traceOpen (nTrace, &trc) == -1) {
+            perror ("error on mapping the trace file");
+            exit (EXIT_FAILURE);
+        }
+        if ((trc.hdr->nOrders > INT_MAX) || (traceValidate (&trc, NUMINGREDIENTS) != trc.hdr->nOrders)) {
+            fprintf (stderr, "Trace file %s is not valid!\n", nTrace);
+            exit (EXIT_FAILURE);
+        }
+        nOrders = (int) trc.hdr->nOrders;
+        traceClose (&trc);
+    }
 
     /* composing command line */
-    if ((key = ftok (".", 'a')) == -1) {
+    if ((key == -1) && ((key = ftok (".", 'a')) == -1)) {
         perror ("error on generating the key");
         exit (EXIT_FAILURE);
     }
-    sprintf (num[1], "%d", key);
 
-    /* creating and initializing the shared memory region and the log file */
-    if ((shmid = shmemCreate (key, sizeof (SHARED_DATA))) == -1) { 
+    /* creating the shared memory region, an arena of named regions that the entities look up */
+    size = sizeof (ARENA) + arenaSpace (nFact * sizeof (SHARED_DATA), SHALIGN) +
+           arenaSpace (nFact * NUMENTITIES * sizeof (RNG_SLOT), CACHELINE);
+    if (nEv[0] != '\0') {
+        size += arenaSpace (nFact * ENTSLOTS (nWorkers) * sizeof (EVENT_BUF), SHALIGN);
+    }
+    if ((shmid = shmemCreate (key, size)) == -1) { 
         perror ("error on creating the shared memory region");
         exit (EXIT_FAILURE);
     }
-    if (shmemAttach (shmid, (void **) &sh) == -1) { 
+    if (shmemAttach (shmid, &arena) == -1) { 
         perror ("error on mapping the shared region on the process address space");
         exit (EXIT_FAILURE);
     }
 
-    /* initialize random generator */
-    srandom ((unsigned int) getpid ());                                
+    /* memory placement, before any page of the shared region is touched */
+    if ((memNode >= 0) && (plBind (arena, size, memNode) == -1)) {
+        perror ("error on binding the shared region to a node");
+        exit (EXIT_FAILURE);
+    }
 
-    /* initialize problem internal status */
-    sh->fSt.st.agentStat        = PREPARING;                            /* the agent prepares ingredients */
-    int w;
-    for (w = 0; w < NUMINGREDIENTS; w++) {
-        sh->fSt.st.watcherStat[w] = WAITING_ING;                              /* watchers are initialized */
-        sh->fSt.ingredients[w]=0;
+    /* carving the shared data (one instance per factory) */
+    arenaInit (arena, size);
+    if ((shBase = arenaAlloc (arena, SHREGION, nFact * sizeof (SHARED_DATA), SHALIGN)) == NULL) {
+        perror ("error on allocating the shared data");
+        exit (EXIT_FAILURE);
+    }
+    if ((rngBase = arenaAlloc (arena, RNGREGION, nFact * NUMENTITIES * sizeof (RNG_SLOT), CACHELINE)) == NULL) {
+        perror ("error on allocating the random generators");
+        exit (EXIT_FAILURE);
     }
-    int s;
-    for (s = 0; s < NUMSMOKERS; s++) {
-        sh->fSt.st.smokerStat[s] = WAITING_2ING;                               /* smokers are initialized */
-        sh->fSt.nCigarettes[s]=0;
+    if ((nEv[0] != '\0') &&                     /* only the slots in use of each factory are given a buffer */
+        ((evBase = arenaAlloc (arena, EVREGION, nFact * ENTSLOTS (nWorkers) * sizeof (EVENT_BUF),
+                               SHALIGN)) == NULL)) {
+        perror ("error on allocating the state transition buffers");
+        exit (EXIT_FAILURE);
     }
 
-    sh->fSt.nIngredients = NUMINGREDIENTS;
-    sh->fSt.nSmokers     = NUMSMOKERS;
+    /* real-time mode: every page of the region is allocated before the entities run */
+    if (rtMode) {
+        rtTouch (arena, size);
+    }
 
-    sh->fSt.nOrders      = NUMORDERS;
+#ifdef PERFCOUNTERS
+    unlink (PERFFILE);                                       /* the entities append their counter reports */
+#endif
 
+    for (f = 0; f < nFact; f++) {
+        sh = shBase + f;
+        ev = (evBase != NULL) ? evBase + f * ENTSLOTS (nWorkers) : NULL;
+        if (local) {
+            placeLocal (ev, rngBase + f * NUMENTITIES, place, nWorkers, matcher);
+        }
 
-    /* create log file */
-    createLog (nFic, &sh->fSt);                                  
-    saveState(nFic,&sh->fSt);
+        /* initialize problem internal status */
+        sh->fSt.st.agentStat        = PREPARING;                            /* the agent prepares ingredients */
+        int w;
+        for (w = 0; w < NUMINGREDIENTS; w++) {
+            sh->fSt.st.watcherStat[w] = WAITING_ING;                              /* watchers are initialized */
+            sh->fSt.ingredients[w]=0;
+        }
+        int s;
+        for (s = 0; s < NUMSMOKERS * nWorkers; s++) {
+            sh->fSt.st.smokerStat[s] = WAITING_2ING;                        /* smoker workers are initialized */
+            sh->fSt.nCigarettes[s]=0;
+            sh->deque[s].top = sh->deque[s].bottom = 0;
+        }
+
+        sh->fSt.nIngredients = NUMINGREDIENTS;
+        sh->fSt.nSmokers     = NUMSMOKERS;
+        sh->fSt.nWorkers     = nWorkers;
+        memset (sh->fStSeq, 0, sizeof (sh->fStSeq));
+        sh->order            = 0;
+        sh->matcher          = matcher;
+        sh->seed             = seed + f;
+        sh->stress           = (stress != 0) ? stress + f : 0;
+        strcpy (sh->trace, nTrace);
+        sh->timeScale        = timeScale;
+        sh->spinNs           = (unsigned int) (spin * 1000.0);
+        sh->rtLock           = rtMode;
+        sh->fSt.nOrders      = nOrders;
+        sh->ckptEvery        = ckptEvery;
+        sh->firstOrder       = 0;
+        sh->ckpt[0]          = '\0';
+        if ((nCk[0] != '\0') &&                              /* the state may be restored from the checkpoint */
+            (ckptPrepare (sh, rngBase + f * NUMENTITIES, factoryName (strcpy (sh->ckpt, nCk), f, nFact), resume) == -1)) {
+            shmemDettach (arena);
+            shmemDestroy (shmid);
+            exit (EXIT_FAILURE);
+        }
+
+        /* initial states begin the timelines */
+        evRecord (ev, ENT_AGENT, sh->fSt.st.agentStat);
+        for (w = 0; w < NUMINGREDIENTS; w++) {
+            evRecord (ev, ENT_WATCHER (w), sh->fSt.st.watcherStat[w]);
+        }
+        for (s = 0; s < NUMSMOKERS * nWorkers; s++) {
+            evRecord (ev, ENT_SMOKER (s), sh->fSt.st.smokerStat[s]);
+        }
 
-    /* initialize semaphore ids */
-    sh->mutex                       = MUTEX;                                /* mutual exclusion semaphore id */
-    sh->waitCigarette               = WAITCIGARETTE;                         
+        /* create log file (a resumed run appends to it) */
+        factoryName (strcpy (nFicF, nFic), f, nFact);
+        if (sh->firstOrder == 0) {
+            createLog (nFicF, &sh->fSt);                                  
+        }
+        saveState(nFicF,&sh->fSt);
+
+        /* initialize semaphore ids (the semaphores of factory f follow those of factory f-1; the launcher
+           waits on the ready and exited semaphores of factory 0 only) */
+        sh->mutex                       = SEM_NU * f + MUTEX;              /* mutual exclusion semaphore id */
+        sh->waitCigarette               = SEM_NU * f + WAITCIGARETTE;                         
  
-    int i;
-    for(i=0;i<NUMINGREDIENTS;i++) {
-       sh->ingredient[i]            = INGREDIENT+i;                                                      
-    }
-    for(s=0;s<NUMSMOKERS;s++) {
-       sh->wait2Ings[s]             = WAIT2INGS+s;                                                      
+        int i;
+        for(i=0;i<NUMINGREDIENTS;i++) {
+           sh->ingredient[i]            = SEM_NU * f + INGREDIENT+i;                                                      
+        }
+        for(s=0;s<NUMSMOKERS * MAXWORKERS;s++) {
+           sh->wait2Ings[s]             = SEM_NU * f + WAIT2INGS+s;                                                      
+        }
+        sh->arrival                     = SEM_NU * f + ARRIVAL;
+        sh->lock[DOM_INVENTORY]         = sh->mutex;              /* the inventory domain keeps the mutex */
+        sh->lock[DOM_DISPATCH]          = global ? sh->mutex : SEM_NU * f + DISPATCH;
+        sh->exited                      = EXITED;
+        sh->ready                       = READY;
     }
+    sh = shBase;
 
     /* creating and initializing the semaphore set */
-    if ((semgid = semCreate (key, SEM_NU)) == -1) { 
+    if ((semgid = semCreate (key, nFact * SEM_NU)) == -1) { 
         perror ("error on creating the semaphore set");
         exit (EXIT_FAILURE);
     }
-    if (semUp (semgid, sh->mutex) == -1) {                   /* enabling access to critical region */
-        perror ("error on executing the up operation for semaphore access");
-        exit (EXIT_FAILURE);
+    for (f = 0; f < nFact; f++) {
+        for (int d = 0; d < NUMDOMAINS; d++) {                        /* enabling access to critical region */
+            if (((d == DOM_INVENTORY) || (shBase[f].lock[d] != shBase[f].mutex)) &&
+                (semUp (semgid, shBase[f].lock[d]) == -1)) {
+                perror ("error on executing the up operation for semaphore access");
+                exit (EXIT_FAILURE);
+            }
+        }
     }
 
-    /* generation of intervening entities processes */                            
-    /* agent process */
-    strcpy (nFicErr + 6, "AG");
-    if ((pidAG = fork ()) < 0)  {                            
-        perror ("error on the fork operation for the agent");
+    /* generation of intervening entities processes (posix_spawn does not copy the launcher address space) */
+    nProc = nFact * (1 + (matcher ? 1 : NUMINGREDIENTS) + NUMSMOKERS * nWorkers);
+    if (semUpBy (semgid, sh->ready, nProc) == -1) {                       /* every entity must announce it is ready */
+        perror ("error on executing the up operation for semaphore access");
         exit (EXIT_FAILURE);
     }
-    if (pidAG == 0) {
-        if (execl (AGENT, AGENT, nFic, num[1], nFicErr, NULL) < 0) {
-            perror ("error on the generation of the agent process");
-            exit (EXIT_FAILURE);
+    nWatchers = (matcher ? 0 : NUMINGREDIENTS);
+    tLaunch = nowNs ();
+    for (f = 0; f < nFact; f++) {
+        factoryName (strcpy (nFicF, nFic), f, nFact);
+        if (nFact > 1) sprintf (num[1], "%d/%u", key, f);
+        else sprintf (num[1], "%d", key);
+
+        /* agent process */
+        strcpy (nFicErr + 6, "AG");
+        pidAG[f] = spawn (AGENT, (char *[]) { AGENT, nFicF, num[1], factoryName (nFicErr, f, nFact), NULL },
+                          &place[PL_AGENT], &sched[PL_AGENT]);
+        /* watcher processes (or the matcher process) */
+        if (matcher) {
+            strcpy (nFicErr + 6, "MT");
+            pidWT[f][0] = spawn (MATCHER, (char *[]) { MATCHER, nFicF, num[1], factoryName (nFicErr, f, nFact), NULL },
+                                 &place[PL_MATCHER], &sched[PL_MATCHER]);
         }
-    }
-    /* watcher processes */
-    strcpy (nFicErr + 6, "WT");
-    for (w = 0; w < NUMINGREDIENTS; w++) {           
-        if ((pidWT[w] = fork ()) < 0) {
-            perror ("error on the fork operation for the watcher");
-            exit (EXIT_FAILURE);
+        strcpy (nFicErr + 6, "WT");
+        for (int w = 0; w < nWatchers; w++) {
+            sprintf(num[0],"%d",w);
+            sprintf(nFicErr+8,"%02d",w); 
+            pidWT[f][w] = spawn (WATCHER, (char *[]) { WATCHER, num[0], nFicF, num[1], factoryName (nFicErr, f, nFact),
+                                                       NULL }, &place[PL_WATCHER], &sched[PL_WATCHER]);
         }
-        sprintf(num[0],"%d",w);
-        sprintf(nFicErr+8,"%02d",w); 
-        if (pidWT[w] == 0)
-            if (execl (WATCHER, WATCHER, num[0], nFic, num[1], nFicErr, NULL) < 0) { 
-                perror ("error on the generation of the watcher process");
-                exit (EXIT_FAILURE);
-            }
-    }
 
-    /* smoker processes */
-    strcpy (nFicErr + 6, "SM");
-    for (s = 0; s < NUMSMOKERS; s++) {           
-        if ((pidSM[s] = fork ()) < 0) {
-            perror ("error on the fork operation for the smoker");
-            exit (EXIT_FAILURE);
+        /* smoker processes */
+        strcpy (nFicErr + 6, "SM");
+        for (int s = 0; s < NUMSMOKERS * nWorkers; s++) {
+            sprintf(num[0],"%d",s);
+            sprintf(nFicErr+8,"%02d",s); 
+            pidSM[f][s] = spawn (SMOKER, (char *[]) { SMOKER, num[0], nFicF, num[1], factoryName (nFicErr, f, nFact),
+                                                      NULL }, &place[PL_SMOKER], &sched[PL_SMOKER]);
         }
-        sprintf(num[0],"%d",s);
-        sprintf(nFicErr+8,"%02d",s); 
-        if (pidSM[s] == 0)
-            if (execl (SMOKER, SMOKER, num[0], nFic, num[1], nFicErr, NULL) < 0) { 
-                perror ("error on the generation of the watcher process");
-                exit (EXIT_FAILURE);
-            }
     }
+    tSpawned = nowNs ();
 
+    /* waiting for all the entities to be ready (a single wake-up when the countdown reaches zero) */
+    if (semWaitZero (semgid, sh->ready, (unsigned int) (deadline * 1000)) == 0) {
+        tReady = nowNs ();
+        fprintf (stderr, "%u entities spawned in %.3f ms, all ready in %.3f ms\n", nProc, (tSpawned - tLaunch) / 1e6,
+                 (tReady - tLaunch) / 1e6);
 
-    /* signaling start of operations */
-    if (semSignal (semgid) == -1) {
-        perror ("error on signaling start of operations");
+        /* signaling start of operations */
+        if (semSignal (semgid) == -1) {
+            perror ("error on signaling start of operations");
+            exit (EXIT_FAILURE);
+        }
+    }
+    else if (errno == EAGAIN) {
+        fprintf (stderr, "watchdog: entities not ready after %g s, tearing the simulation down\n", deadline);
+        for (f = 0; f < nFact; f++) {
+            if (nFact > 1) fprintf (stderr, " factory %u\n", f);
+            dumpEntities (shBase + f, pidAG[f], pidWT[f], pidSM[f]);
+        }
+        for (f = 0; f < nFact; f++) {
+            killEntities (shBase + f, pidAG[f], pidWT[f], pidSM[f]);
+        }
+        wedged = true;
+        deadline = 0.0;                                                    /* the remaining processes are reaped */
+    }
+    else {
+        perror ("error on waiting for the entities to be ready");
         exit (EXIT_FAILURE);
     }
 
     /* waiting for the termination of the intervening entities processes */
+    tProgress = nowNs ();
     m = 0;
-    do {
+    while (m < nProc) {
+        if (deadline > 0.0) {
+            /* the watchdog wakes up when an entity exits or every tick, and never blocks in wait */
+            if ((semDownTimed (semgid, sh->exited, WATCHDOGTICK) == -1) && (errno != EAGAIN) && (errno != EINTR)) {
+                perror ("error on the down operation for semaphore access");
+                exit (EXIT_FAILURE);
+            }
+            while ((m < nProc) && ((info = waitpid (-1, &status, WNOHANG)) > 0)) {
+                if (!WIFEXITED (status) || (WEXITSTATUS (status) != EXIT_SUCCESS)) {
+                    failed += 1;
+                }
+                m += 1;
+            }
+            beats = 0;
+            for (f = 0; f < nFact; f++) {
+                for (e = 0; e < NUMBEATS; e++) {
+                    beats += __atomic_load_n (&shBase[f].beat[e], __ATOMIC_RELAXED);
+                }
+            }
+            if (beats != lastBeats) {
+                lastBeats = beats;
+                tProgress = nowNs ();
+            }
+            else if ((m < nProc) && (nowNs () - tProgress > deadline * 1e9)) {
+                fprintf (stderr, "watchdog: no progress for %g s, tearing the simulation down\n", deadline);
+                for (f = 0; f < nFact; f++) {
+                    if (nFact > 1) fprintf (stderr, " factory %u\n", f);
+                    dumpEntities (shBase + f, pidAG[f], pidWT[f], pidSM[f]);
+                }
+                for (f = 0; f < nFact; f++) {
+                    killEntities (shBase + f, pidAG[f], pidWT[f], pidSM[f]);
+                }
+                wedged = true;
+                deadline = 0.0;                                            /* the remaining processes are reaped */
+            }
+            continue;
+        }
         info = wait (&status);
         if (info == -1) { 
             perror ("error on aiting for an intervening process");
             exit (EXIT_FAILURE);
         }
+        if (!WIFEXITED (status) || (WEXITSTATUS (status) != EXIT_SUCCESS)) {
+            failed += 1;
+        }
         m += 1;
-    } while (m < 1 + NUMINGREDIENTS + NUMSMOKERS);
+    }
+
+    if (wedged) {
+        nRep[0] = nEv[0] = '\0';                                         /* the simulation did not complete */
+    }
+    else {
+        for (f = 0; f < nFact; f++) {                          /* the final state closes the log of each factory */
+            saveState (factoryName (strcpy (nFicF, nFic), f, nFact), &shBase[f].fSt);
+        }
+        memset (&sleepErr, 0, sizeof (sleepErr));
+        for (f = 0; f < nFact; f++) {
+            histoMerge (&sleepErr, &shBase[f].sleepError);
+        }
+        if (sleepErr.count > 0) {
+            fprintf (stderr, "%llu sleeps, time past the deadline: mean %.1f us, p99 %.1f us, max %.1f us\n",
+                     (unsigned long long) sleepErr.count, histoMean (&sleepErr) / 1e3,
+                     histoPercentile (&sleepErr, 0.99) / 1e3, sleepErr.max / 1e3);
+        }
+    }
+    if (nRep[0] != '\0') {
+        writeReport (nRep, shBase, nFact, (tSpawned - tLaunch) / 1e6, (tReady - tLaunch) / 1e6);
+    }
+    for (f = 0; (nEv[0] != '\0') && (f < nFact); f++) {
+        if (evExport (factoryName (strcpy (nEvF, nEv), f, nFact), shBase + f,
+                      evBase + f * ENTSLOTS (nWorkers)) == -1) {
+            perror ("error on exporting the state timelines");
+            exit (EXIT_FAILURE);
+        }
+    }
 
     /* destruction of semaphore set and shared region */
     if (semDestroy (semgid) == -1) {
         perror ("error on destructing the semaphore set");
         exit (EXIT_FAILURE);
     }
-    if (shmemDettach (sh) == -1) { 
+    if (shmemDettach (arena) == -1) { 
         perror ("error on unmapping the shared region off the process address space");
         exit (EXIT_FAILURE);
     }
@@ -211,5 +679,369 @@ int main (int argc, char *argv[])
         exit (EXIT_FAILURE);
     }
 
+    if (wedged) {
+        return EXIT_FAILURE;
+    }
+    if (failed > 0) {
+        fprintf (stderr, "%d intervening process(es) did not terminate successfully!\n", failed);
+        return EXIT_FAILURE;
+    }
+
     return EXIT_SUCCESS;
 }
+
+/**
+ *  \brief Writing the benchmark report.
+ *
+ *  A single JSON object holds the configuration of the run, the throughput (orders per second, from the
+ *  preparation of the first order to the completion of the last cigarette) and the latency histogram
+ *  of each benchmark stage, in nanoseconds, together with the launch times, the error of the rolling and
+ *  smoking sleeps and the wake-up latencies of the agent and of the smoker workers. In multi-tenant mode there is one line per factory, which also holds the factory number.
+ *
+ *  \param nRep name of the report file
+ *  \param sh pointer to shared memory region
+ *  \param nFact number of factories in the region
+ *  \param launchMs time taken to spawn all the entities (ms)
+ *  \param readyMs time from the launch until all the entities were ready (ms)
+ */
+static void writeReport (char nRep[], SHARED_DATA *sh, unsigned int nFact, double launchMs, double readyMs)
+{
+    FILE *fic;                                                                                      /* file descriptor */
+    double elapsed;                                                                          /* elapsed time (s) */
+    int nRun;                                                                      /* number of orders of the run */
+    int st;
+
+    if ((fic = fopen (nRep, "w")) == NULL) {
+        perror ("error on opening the report file");
+        exit (EXIT_FAILURE);
+    }
+
+    for (unsigned int f = 0; f < nFact; f++, sh++) {
+        if (nFact > 1) fprintf (fic, "{\"factory\":%u,", f);                 /* multi-tenant mode */
+        else fputc ('{', fic);
+        nRun = sh->fSt.nOrders - (int) sh->firstOrder;                    /* orders of this run, if resumed */
+        elapsed = (nRun > 0) ? (sh->lastDone - sh->firstCreated) / 1e9 : 0.0;
+        if (sh->firstOrder > 0) fprintf (fic, "\"resumed_from\":%u,", sh->firstOrder);
+        fprintf (fic, "\"orders\":%d,\"smokers\":%d,\"workers\":%d,\"matcher\":%s,\"locking\":\"%s\","
+                      "\"timeScale\":%g,\"seed\":%llu,\"trace\":",
+                 sh->fSt.nOrders, sh->fSt.nSmokers, sh->fSt.nWorkers, sh->matcher ? "true" : "false",
+                 (sh->lock[DOM_DISPATCH] == sh->mutex) ? "global" : "sharded", sh->timeScale, sh->seed);
+        jsonPrintString (fic, sh->trace);                                         /* any path, escaped */
+        fprintf (fic, ",\"launch_ms\":%.3f,\"ready_ms\":%.3f,\"elapsed_s\":%.6f,\"orders_per_s\":%.1f,"
+                      "\"latency_ns\":{",
+                 launchMs, readyMs, elapsed, (elapsed > 0.0) ? nRun / elapsed : 0.0);
+        for (st = 0; st < NUMSTAGES; st++) {
+            fprintf (fic, "%s\"%s\":", (st > 0) ? "," : "", stageName[st]);
+            histoPrintJson (fic, &sh->latency[st]);
+        }
+        fprintf (fic, "},\"spin_us\":%g,\"sleep_error_ns\":", sh->spinNs / 1e3);
+        histoPrintJson (fic, &sh->sleepError);
+        fprintf (fic, ",\"wake_ns\":{");
+        for (st = 0; st < NUMWAKES; st++) {
+            fprintf (fic, "%s\"%s\":", (st > 0) ? "," : "", wakeName[st]);
+            histoPrintJson (fic, &sh->wake[st]);
+        }
+        fprintf (fic, "}}\n");
+    }
+
+    if (fclose (fic) == EOF) {
+        perror ("error on closing the report file");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief Dumping the state of every entity (watchdog).
+ *
+ *  For each entity process, its pid, its state, its heartbeat and the semaphore it is blocked on are
+ *  written to stderr. The shared data is read without entering the critical region, since the mutex
+ *  may be held by a wedged process.
+ *
+ *  \param sh pointer to shared memory region
+ *  \param pidAG agent process identifier
+ *  \param pidWT watcher (or matcher) process identifiers
+ *  \param pidSM smoker worker process identifiers
+ */
+static void dumpEntities (SHARED_DATA *sh, int pidAG, int pidWT[], int pidSM[])
+{
+    char name[32];                                                                               /* entity name */
+    char sem[32];                                                                /* blocking semaphore name */
+    unsigned int b, e, i;
+
+    for (e = 0; e < NUMBEATS; e++) {
+        int pid, state = -1;
+
+        if (e == ENT_AGENT) {
+            strcpy (name, "agent");
+            pid = pidAG;
+            state = sh->fSt.st.agentStat;
+        }
+        else if (e == HB_MATCHER) {
+            if (!sh->matcher) continue;
+            strcpy (name, "matcher");
+            pid = pidWT[0];
+        }
+        else if (e < (unsigned int) ENT_SMOKER (0)) {
+            if (sh->matcher) continue;
+            sprintf (name, "watcher %u", e - ENT_WATCHER (0));
+            pid = pidWT[e - ENT_WATCHER (0)];
+            state = sh->fSt.st.watcherStat[e - ENT_WATCHER (0)];
+        }
+        else {
+            i = e - ENT_SMOKER (0);
+            if (i >= (unsigned int) (sh->fSt.nSmokers * sh->fSt.nWorkers)) continue;
+            sprintf (name, "smoker %u.%u", i / sh->fSt.nWorkers, i % sh->fSt.nWorkers);
+            pid = pidSM[i];
+            state = sh->fSt.st.smokerStat[i];
+        }
+
+        b = __atomic_load_n (&sh->blockedOn[e], __ATOMIC_RELAXED);
+        if (b == 0) strcpy (sem, "-");
+        else if (b == sh->mutex) strcpy (sem, "mutex");
+        else if (b == sh->lock[DOM_DISPATCH]) strcpy (sem, "dispatch");
+        else if (b == sh->waitCigarette) strcpy (sem, "waitCigarette");
+        else if (b == sh->arrival) strcpy (sem, "arrival");
+        else if (b == sh->exited) strcpy (sem, "exited");
+        else if (b == sh->ready) strcpy (sem, "ready");
+        else if ((b >= sh->ingredient[0]) && (b < sh->ingredient[0] + NUMINGREDIENTS))
+            sprintf (sem, "ingredient[%u]", b - sh->ingredient[0]);
+        else if ((b >= sh->wait2Ings[0]) && (b < sh->wait2Ings[0] + NUMSMOKERS * MAXWORKERS))
+            sprintf (sem, "wait2Ings[%u]", b - sh->wait2Ings[0]);
+        else sprintf (sem, "%u", b);
+
+        fprintf (stderr, "  %-12s pid %-7d state %-14s beats %-10llu blocked on %s\n", name, pid,
+                 (state < 0) ? "-" : evStateName (e, (unsigned int) state), sh->beat[e], sem);
+    }
+}
+
+/**
+ *  \brief Killing every entity process (watchdog).
+ *
+ *  \param sh pointer to shared memory region
+ *  \param pidAG agent process identifier
+ *  \param pidWT watcher (or matcher) process identifiers
+ *  \param pidSM smoker worker process identifiers
+ */
+static void killEntities (SHARED_DATA *sh, int pidAG, int pidWT[], int pidSM[])
+{
+    int n;
+
+    kill (pidAG, SIGKILL);
+    for (n = 0; n < (sh->matcher ? 1 : sh->fSt.nIngredients); n++) {
+        kill (pidWT[n], SIGKILL);
+    }
+    for (n = 0; n < sh->fSt.nSmokers * sh->fSt.nWorkers; n++) {
+        kill (pidSM[n], SIGKILL);
+    }
+}
+
+/**
+ *  \brief Spawning of an entity process.
+ *
+ *  <tt>posix_spawn</tt> creates the process without copying the address space of the launcher, so the
+ *  launch time does not grow with its size. In the multi-call binary the entity runs the launcher's own
+ *  image (it dispatches on <tt>args[0]</tt>), or, with <tt>-f</tt>, is forked straight into its entry point
+ *  without any exec. The process is pinned to the CPUs of its placement, if any, and gets the real-time
+ *  scheduling of its class, if any. The launcher exits on failure.
+ *
+ *  \param path name of the program
+ *  \param args command line arguments (NULL terminated)
+ *  \param pl pointer to the placement of the entity class
+ *  \param rt pointer to the scheduling of the entity class
+ *
+ *  \return process identifier
+ */
+static int spawn (char *path, char *args[], const PLACEMENT *pl, const RT_SCHED *rt)
+{
+    pid_t pid;                                                                           /* process identifier */
+    int err;                                                                                       /* error code */
+    char *image = path;                                                             /* program actually run */
+
+#ifdef MULTICALL
+    if (forkOnly) {
+        int argc = 0;
+
+        fflush (NULL);                                          /* no buffered output is duplicated in the child */
+        if ((pid = fork ()) < 0) {
+            fprintf (stderr, "error on the fork operation for the %s: ", path + 2);
+            perror (NULL);
+            exit (EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            if (plPin (0, pl) == -1) {                                         /* pinned before doing any work */
+                perror ("error on pinning the entity process");
+                exit (EXIT_FAILURE);
+            }
+            if (rtApply (0, rt) == -1) {
+                perror ("error on setting the real-time scheduling of the entity process");
+                exit (EXIT_FAILURE);
+            }
+            while (args[argc] != NULL) {
+                argc += 1;
+            }
+            exit (entryFind (path) (argc, args));
+        }
+        return (int) pid;
+    }
+    image = SELF;
+#endif
+    if ((err = posix_spawn (&pid, image, NULL, NULL, args, environ)) != 0) {
+        errno = err;
+        fprintf (stderr, "error on the generation of the %s process: ", path + 2);
+        perror (NULL);
+        exit (EXIT_FAILURE);
+    }
+    if (plPin (pid, pl) == -1) {                        /* the entity waits for the start gate, still unpinned */
+        perror ("error on pinning the entity process");
+        exit (EXIT_FAILURE);
+    }
+    if (rtApply (pid, rt) == -1) {
+        perror ("error on setting the real-time scheduling of the entity process");
+        exit (EXIT_FAILURE);
+    }
+    return (int) pid;
+}
+
+/**
+ *  \brief Name of a file of a factory.
+ *
+ *  In multi-tenant mode the suffix <tt>.f</tt> is appended to the name, unless it is empty (stdout).
+ *
+ *  \param name file name (the buffer must hold the suffix)
+ *  \param f factory
+ *  \param nFact number of factories in the region
+ *
+ *  \return name
+ */
+static char *factoryName (char name[], unsigned int f, unsigned int nFact)
+{
+    if ((nFact > 1) && (name[0] != '\0')) {
+        sprintf (name + strlen (name), ".%u", f);
+    }
+    return name;
+}
+
+/**
+ *  \brief Preparing the checkpoint file of a factory.
+ *
+ *  For a new run the file is created with the configuration of the run. For a resumed run the configuration
+ *  is checked and the state of the latest checkpoint (full state, random generators and latency histograms)
+ *  is restored into the shared region, the run going on from the first order not completed. The reason of a
+ *  failure is written to stderr.
+ *
+ *  \param sh pointer to the shared data of the factory (already initialized)
+ *  \param rng random generators of the factory (NUMENTITIES)
+ *  \param nCk name of the checkpoint file
+ *  \param resume flag set when the run is resumed
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs
+ */
+static int ckptPrepare (SHARED_DATA *sh, RNG_SLOT rng[], char nCk[], bool resume)
+{
+    CKPT *ck;                                                                               /* mapped checkpoint */
+    const CKPT_STATE *st;                                                                    /* latest checkpoint */
+
+    if ((ck = ckptMap (nCk, !resume)) == NULL) {
+        perror ("error on mapping the checkpoint file");
+        return -1;
+    }
+    if (!resume) {
+        ck->nOrders = sh->fSt.nOrders;
+        ck->nWorkers = sh->fSt.nWorkers;
+        ck->matcher = sh->matcher;
+        ck->seed = sh->seed;
+        strcpy (ck->trace, sh->trace);
+        ck->magic = CKPTMAGIC;
+    }
+    else {
+        if ((ck->magic != CKPTMAGIC) || (ck->nOrders != sh->fSt.nOrders) || (ck->nWorkers != sh->fSt.nWorkers) ||
+            (ck->matcher != sh->matcher) || (strcmp (ck->trace, sh->trace) != 0)) {
+            fprintf (stderr, "Checkpoint %s was taken with other orders, workers, matcher or trace options!\n", nCk);
+            ckptUnmap (ck);
+            return -1;
+        }
+        if ((st = ckptLatest (ck)) == NULL) {
+            fprintf (stderr, "Checkpoint %s holds no complete checkpoint!\n", nCk);
+            ckptUnmap (ck);
+            return -1;
+        }
+        sh->seed = ck->seed;
+        sh->fSt = st->fSt;
+        for (unsigned int e = 0; e < NUMENTITIES; e++) {
+            rng[e].g = st->rng[e];
+        }
+        memcpy (sh->latency, st->latency, sizeof (st->latency));
+        sh->firstOrder = st->done;
+        fprintf (stderr, "%s: resuming after order %u of %d\n", nCk, st->done, ck->nOrders);
+    }
+    if (ckptUnmap (ck) == -1) {
+        perror ("error on unmapping the checkpoint file");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ *  \brief Finding an entity class by name.
+ *
+ *  \param name class name (not necessarily null terminated)
+ *  \param len length of the name
+ *
+ *  \return class, or -1 if there is no class with that name
+ */
+static int placeClass (const char *name, size_t len)
+{
+    for (int c = 0; c < NUMCLASSES; c++) {
+        if ((strlen (className[c]) == len) && (strncmp (name, className[c], len) == 0)) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+/**
+ *  \brief Binding the per entity data to the node of its owner.
+ *
+ *  The random generators and the state transition buffers of the entities of each class that has a placement
+ *  on a known node are bound to that node. The slots of a class are contiguous, and only the pages entirely
+ *  inside them are bound, so a page shared with another class keeps the policy of the block. The shared data,
+ *  deques and order timestamps included, is written by entities of several classes and keeps it as well.
+ *
+ *  \param ev state transition buffers of the factory (NULL, if the transitions are not recorded)
+ *  \param rng random generators of the factory (NUMENTITIES)
+ *  \param place placement of each entity class
+ *  \param nWorkers number of workers of each smoker
+ *  \param matcher flag set when a matcher replaces the watchers
+ */
+static void placeLocal (EVENT_BUF ev[], RNG_SLOT rng[], PLACEMENT place[], int nWorkers, bool matcher)
+{
+    /* entity slots of each class: agent, watchers (or matcher) and smoker workers */
+    int cl[3] = { PL_AGENT, matcher ? PL_MATCHER : PL_WATCHER, PL_SMOKER };
+    unsigned int first[3] = { ENT_AGENT, ENT_WATCHER (0), ENT_SMOKER (0) };
+    unsigned int n[3] = { 1, NUMINGREDIENTS, NUMSMOKERS * nWorkers };
+    int node;
+
+    for (int c = 0; c < 3; c++) {
+        if (!place[cl[c]].on || ((node = place[cl[c]].node) < 0)) {
+            continue;
+        }
+        if ((plBind (&rng[first[c]], n[c] * sizeof (RNG_SLOT), node) == -1) ||
+            ((ev != NULL) && (plBind (&ev[first[c]], n[c] * sizeof (EVENT_BUF), node) == -1))) {
+            perror ("error on binding the per entity data to a node");
+            exit (EXIT_FAILURE);
+        }
+    }
+}
+
+#ifndef MULTICALL
+/**
+ *  \brief Main program.
+ *
+ *  Stand-alone launcher executable.
+ */
+int main (int argc, char *argv[])
+{
+    return launcherMain (argc, argv);
+}
+#endif /* MULTICALL */
@@ -0,0 +1,121 @@
+/**
+ *  \file realtime.c (implementation file)
+ *
+ *  \brief Real-time mode of the entities, for low jitter latency measurements.
+ *
+ *  Each entity class may be given a real-time scheduling policy (<tt>SCHED_FIFO</tt> or <tt>SCHED_RR</tt>)
+ *  and priority, and the memory of every entity is locked and pre-touched before operations start, so
+ *  that no page fault happens while the latencies are measured. Both require the appropriate privileges
+ *  (or <tt>RLIMIT_RTPRIO</tt> and <tt>RLIMIT_MEMLOCK</tt> limits).
+ *
+ *  Defined operations:
+ *     \li parsing of a scheduling specification
+ *     \li application of a scheduling policy to a process
+ *     \li pre-touching of a memory range
+ *     \li locking of the memory of the calling process.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include "realtime.h"
+
+/**
+ *  \brief Parsing of a scheduling specification.
+ *
+ *  The specification is <tt>fifo:prio</tt> or <tt>rr:prio</tt>, the priority being within the range of the
+ *  policy.
+ *
+ *  \param spec specification
+ *  \param rt pointer to the scheduling
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if the specification is not valid
+ */
+int rtParse (const char *spec, RT_SCHED *rt)
+{
+    char *end;
+
+    if (strncmp (spec, "fifo:", 5) == 0) {
+        rt->policy = SCHED_FIFO;
+        spec += 5;
+    }
+    else if (strncmp (spec, "rr:", 3) == 0) {
+        rt->policy = SCHED_RR;
+        spec += 3;
+    }
+    else return -1;
+    rt->prio = (int) strtol (spec, &end, 10);
+    if ((end == spec) || (*end != '\0') || (rt->prio < sched_get_priority_min (rt->policy)) ||
+        (rt->prio > sched_get_priority_max (rt->policy))) {
+        return -1;
+    }
+    rt->on = true;
+
+    return 0;
+}
+
+/**
+ *  \brief Application of a scheduling policy to a process.
+ *
+ *  Nothing is done if no policy was given.
+ *
+ *  \param pid process identifier (0 for the calling process)
+ *  \param rt pointer to the scheduling
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int rtApply (pid_t pid, const RT_SCHED *rt)
+{
+    struct sched_param param;
+
+    if (!rt->on) {
+        return 0;
+    }
+    memset (&param, 0, sizeof (param));
+    param.sched_priority = rt->prio;
+    return sched_setscheduler (pid, rt->policy, &param);
+}
+
+/**
+ *  \brief Pre-touching of a memory range.
+ *
+ *  Every page is written (with its own contents), so it is allocated before it is used.
+ *
+ *  \param addr beginning of the range
+ *  \param len length of the range (bytes)
+ */
+void rtTouch (void *addr, size_t len)
+{
+    volatile char *p = addr;
+    size_t page = (size_t) sysconf (_SC_PAGESIZE);
+
+    for (size_t i = 0; i < len; i += page) {
+        p[i] = p[i];
+    }
+}
+
+/**
+ *  \brief Locking of the memory of the calling process.
+ *
+ *  Every page mapped now or later is locked in memory (which faults in the mapped ones, the shared region
+ *  included), and RTSTACK bytes of stack are pre-touched.
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int rtLock (void)
+{
+    volatile char stack[RTSTACK];                                     /* pages the stack will grow into */
+
+    if (mlockall (MCL_CURRENT | MCL_FUTURE) == -1) {
+        return -1;
+    }
+    rtTouch ((void *) stack, sizeof (stack));
+
+    return 0;
+}
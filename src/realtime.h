@@ -0,0 +1,88 @@
+/**
+ *  \file realtime.h (interface file)
+ *
+ *  \brief Real-time mode of the entities, for low jitter latency measurements.
+ *
+ *  Each entity class may be given a real-time scheduling policy (<tt>SCHED_FIFO</tt> or <tt>SCHED_RR</tt>)
+ *  and priority, and the memory of every entity is locked and pre-touched before operations start, so
+ *  that no page fault happens while the latencies are measured. Both require the appropriate privileges
+ *  (or <tt>RLIMIT_RTPRIO</tt> and <tt>RLIMIT_MEMLOCK</tt> limits).
+ *
+ *  Defined operations:
+ *     \li parsing of a scheduling specification
+ *     \li application of a scheduling policy to a process
+ *     \li pre-touching of a memory range
+ *     \li locking of the memory of the calling process.
+ */
+
+#ifndef REALTIME_H_
+#define REALTIME_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+/** \brief size of the stack pre-touched by each entity (bytes) */
+#define RTSTACK                (256 * 1024)
+
+/**
+ *  \brief Definition of <em>scheduling</em> data type.
+ */
+typedef struct {
+    /** \brief flag set when a policy is given */
+    bool on;
+    /** \brief scheduling policy */
+    int policy;
+    /** \brief static priority */
+    int prio;
+} RT_SCHED;
+
+/**
+ *  \brief Parsing of a scheduling specification.
+ *
+ *  The specification is <tt>fifo:prio</tt> or <tt>rr:prio</tt>, the priority being within the range of the
+ *  policy.
+ *
+ *  \param spec specification
+ *  \param rt pointer to the scheduling
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if the specification is not valid
+ */
+extern int rtParse (const char *spec, RT_SCHED *rt);
+
+/**
+ *  \brief Application of a scheduling policy to a process.
+ *
+ *  Nothing is done if no policy was given.
+ *
+ *  \param pid process identifier (0 for the calling process)
+ *  \param rt pointer to the scheduling
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int rtApply (pid_t pid, const RT_SCHED *rt);
+
+/**
+ *  \brief Pre-touching of a memory range.
+ *
+ *  Every page is written (with its own contents), so it is allocated before it is used.
+ *
+ *  \param addr beginning of the range
+ *  \param len length of the range (bytes)
+ */
+extern void rtTouch (void *addr, size_t len);
+
+/**
+ *  \brief Locking of the memory of the calling process.
+ *
+ *  Every page mapped now or later is locked in memory (which faults in the mapped ones, the shared region
+ *  included), and RTSTACK bytes of stack are pre-touched.
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int rtLock (void);
+
+#endif /* REALTIME_H_ */
@@ -16,6 +16,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <sched.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <sys/types.h>
@@ -29,9 +30,24 @@
 #include "probDataStruct.h"
 #include "logging.h"
 #include "sharedDataSync.h"
+#include "arena.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
-
+#include "stats.h"
+#include "eventTrace.h"
+#include "lockDomain.h"
+#include "perfCounters.h"
+#include "prng.h"
+#include "trace.h"
+#include "entityMain.h"
+#include "checkpoint.h"
+#include "realtime.h"
+
+
+/** \brief life cycle phases of the agent (index in the counters report) */
+#define  PH_PREPARE       0
+#define  PH_WAITCIG       1
+#define  PH_CLOSE         2
 
 /** \brief logging file name */
 static char nFic[51];
@@ -45,18 +61,39 @@ static int semgid;
 /** \brief pointer to shared memory region */
 static SHARED_DATA *sh;
 
-static void prepareIngredients ();
+/** \brief state transition buffers of the factory (NULL, if transitions are not recorded) */
+static EVENT_BUF *ev;
+
+/** \brief pseudo random generators of the factory (in the shared region, so they can be checkpointed) */
+static RNG_SLOT *rngs;
+
+/** \brief pseudo random generator of the agent */
+static PRNG *rng;
+
+/** \brief mapped checkpoint file (NULL, if checkpoints are disabled) */
+static CKPT *ck = NULL;
+
+/** \brief flag set when orders are replayed from a trace */
+static bool replay = false;
+
+/** \brief mapped order trace */
+static TRACE trc;
+
+static void prepareIngredients (unsigned int order);
 static void waitForCigarette ();
 static void closeFactory ();
+static void checkpoint (unsigned int done);
 
 /**
- *  \brief Main program.
+ *  \brief Entry point of the agent (main program of its stand-alone executable).
  *
  *  Its role is to generate the life cycle of one of intervening entities in the problem: the agent.
  */
-int main (int argc, char *argv[])
+int agentMain (int argc, char *argv[])
 {
     int key;                                          /*access key to shared memory and semaphore set */
+    int factory = 0;                                          /* factory in a multi-tenant region (key/factory) */
+    void *arena;                                                        /* beginning of the shared block */
     char *tinp;                                                     /* numerical parameters test flag */
 
     /* validation of command line parameters */
@@ -72,7 +109,10 @@ int main (int argc, char *argv[])
     }
     strcpy (nFic, argv[1]);
     key = (unsigned int) strtol (argv[2], &tinp, 0);
-    if (*tinp != '\0') {
+    if (*tinp == '/') {
+        factory = (int) strtol (tinp + 1, &tinp, 0);
+    }
+    if ((*tinp != '\0') || (factory < 0)) {
         fprintf (stderr, "Error on the access key communication!\n");
         return EXIT_FAILURE;
     }
@@ -87,29 +127,100 @@ int main (int argc, char *argv[])
         perror ("error on connecting to the shared memory region");
         return EXIT_FAILURE;
     }
-    if (shmemAttach (shmid, (void **) &sh) == -1) { 
+    if (shmemAttach (shmid, &arena) == -1) { 
         perror ("error on mapping the shared region on the process address space");
         return EXIT_FAILURE;
     }
+    if ((sh = arenaFind (arena, SHREGION, NULL)) == NULL) {
+        perror ("error on looking up the shared data");
+        return EXIT_FAILURE;
+    }
+    sh += factory;                                                   /* shared data of the factory */
+    if ((ev = arenaFind (arena, EVREGION, NULL)) != NULL) {                       /* transitions are recorded */
+        ev += factory * ENTSLOTS (sh->fSt.nWorkers);
+    }
+    semStress (sh->stress, ENT_AGENT);                                          /* stress mode, if enabled */
+    semWatch (&sh->blockedOn[ENT_AGENT], &sh->beat[ENT_AGENT]);                 /* progress seen by the watchdog */
 
-    /* initialize random generator */
-    srandom ((unsigned int) getpid ());                                      
+    /* initialize random generator (stream 0 belongs to the agent), unless it was restored from a checkpoint */
+    if ((rngs = arenaFind (arena, RNGREGION, NULL)) == NULL) {
+        perror ("error on looking up the random generators");
+        return EXIT_FAILURE;
+    }
+    rngs += factory * NUMENTITIES;
+    rng = &rngs[ENT_AGENT].g;
+    if (sh->firstOrder == 0) {
+        prngSeed (rng, sh->seed, 0);
+    }
+
+    /* mapping the checkpoint file */
+    if ((sh->ckpt[0] != '\0') && ((ck = ckptMap (sh->ckpt, false)) == NULL)) {
+        perror ("error on mapping the checkpoint file");
+        return EXIT_FAILURE;
+    }
+
+    /* mapping the order trace */
+    if (sh->trace[0] != '\0') {
+        if (traceOpen (sh->trace, &trc) == -1) {
+            perror ("error on mapping the trace file");
+            return EXIT_FAILURE;
+        }
+        replay = true;
+    }
+
+    /* real-time mode: no page faults once operations start */
+    if (sh->rtLock && (rtLock () == -1)) {
+        perror ("error on locking the process memory");
+        return EXIT_FAILURE;
+    }
+
+    /* announcing the entity is ready and waiting for the start of operations */
+    if (semDown (semgid, sh->ready) == -1) {
+        perror ("error on the down operation for semaphore access (AG)");
+        return EXIT_FAILURE;
+    }
+    if (semWaitStart (semgid) == -1) {
+        perror ("error on waiting for the start of operations (AG)");
+        return EXIT_FAILURE;
+    }
+
+    /* counters of the life cycle phases (only when built with PERFCOUNTERS) */
+    PERF_OPEN ("agent", -1, 3, "prepareIngredients", "waitForCigarette", "closeFactory");
 
     /* simulation of the life cycle of the agent */
 
-    int nOrders=0;
+    int nOrders=sh->firstOrder;
     while(nOrders < sh->fSt.nOrders) {
-       prepareIngredients();
+       prepareIngredients(nOrders);
        waitForCigarette();
 
        nOrders++;
+       if ((ck != NULL) && (nOrders % sh->ckptEvery == 0) && (nOrders < sh->fSt.nOrders)) {
+           checkpoint (nOrders);
+       }
     }
 
     closeFactory();
 
+    if ((ck != NULL) && (ckptUnmap (ck) == -1)) {
+        perror ("error on unmapping the checkpoint file");
+        return EXIT_FAILURE;
+    }
+
+    if (replay) {
+        traceClose (&trc);
+    }
+
+    PERF_REPORT ();
+
+    if (semUp (semgid, sh->exited) == -1) {                                     /* the launcher reaps the process */
+        perror ("error on the up operation for semaphore access (AG)");
+        return EXIT_FAILURE;
+    }
+
     /* unmapping the shared region off the process address space */
 
-    if (shmemDettach (sh) == -1) { 
+    if (shmemDettach (arena) == -1) { 
         perror ("error on unmapping the shared region off the process address space");
         return EXIT_FAILURE;;
     }
@@ -120,47 +231,68 @@ int main (int argc, char *argv[])
 /**
  *  \brief agent prepares 2 ingredients
  *
- *  The agent updates state and randomly selects a pack of 2 different ingredients to be generated.
+ *  The agent updates state and randomly selects a pack of 2 different ingredients to be generated
+ *  (or takes the pack of the order from the trace being replayed).
  *  The inventory is updated to new existences of ingredients.
  *  Both ingredients generated should be notified to watcher using different semaphores. 
+ *  In matcher mode a single notification is issued for the complete order.
+ *
+ *  \param order id of the order being prepared
  */
-static void prepareIngredients ()
+static void prepareIngredients (unsigned int order)
 {
 
-    int ing = rand() % sh->fSt.nIngredients;
-    int ing2;
+    unsigned int ing, ing2;
+
+    if (replay) {
+        traceOrder (&trc, order, &ing, &ing2);
+    }
+    else prngPair (rng, sh->fSt.nIngredients, &ing, &ing2);               /* pack of 2 different ingredients */
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                      /* enter critical region */
+    if (ldEnter (semgid, sh, LK_INVENTORY) == -1) {                                               /* enter critical region */
         perror ("error on the up operation for semaphore access (AG)");
         exit (EXIT_FAILURE);
     }
 
     /* TODO: insert your code here */
     /* Preparando os ingredientes */
-    sh->fSt.st.agentStat = PREPARING;
-
-    do { ing2 = rand() % sh->fSt.nIngredients; }
-    while(ing2 == ing);
+    __atomic_store_n (&sh->fSt.st.agentStat, PREPARING, __ATOMIC_RELEASE);
+    evRecord (ev, ENT_AGENT, PREPARING);
 
     sh->fSt.ingredients[ing] += 1;
     sh->fSt.ingredients[ing2] += 1;
-    saveState(nFic, &sh->fSt);
+    sh->order = order;
+    sh->stamp[order % ORDERSLOTS].created = nowNs ();
+    if (order == sh->firstOrder) {
+        sh->firstCreated = sh->stamp[order % ORDERSLOTS].created;
+    }
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                        /* leave critical region */
+    if (ldLeave (semgid, sh, LK_INVENTORY) == -1) {                                               /* leave critical region */
         perror ("error on the up operation for semaphore access (AG)");
         exit (EXIT_FAILURE);
     }
+    saveStateSnapshot (nFic, &sh->fSt, sh->fStSeq, SEQSLOTS (sh->fSt.nWorkers));
 
     /* TODO: insert your code here */
-    /* diferentes semaforos para os ingredientes */
-    if (semUp (semgid, sh->ingredient[ing]) == -1) {                                                        /* leave critical region */
-        perror ("error on the up operation for semaphore access (AG)");
-        exit (EXIT_FAILURE);
+    if (sh->matcher) {                                          /* the matcher is notified once per complete order */
+        if (semUp (semgid, sh->arrival) == -1) {
+            perror ("error on the up operation for semaphore access (AG)");
+            exit (EXIT_FAILURE);
+        }
     }
-    if (semUp (semgid, sh->ingredient[ing2]) == -1) {                                                        /* leave critical region */
-        perror ("error on the up operation for semaphore access (AG)");
-        exit (EXIT_FAILURE);
+    else {
+        /* diferentes semaforos para os ingredientes */
+        if (semUp (semgid, sh->ingredient[ing]) == -1) {                                                    /* leave critical region */
+            perror ("error on the up operation for semaphore access (AG)");
+            exit (EXIT_FAILURE);
+        }
+        if (semUp (semgid, sh->ingredient[ing2]) == -1) {                                                   /* leave critical region */
+            perror ("error on the up operation for semaphore access (AG)");
+            exit (EXIT_FAILURE);
+        }
     }
+
+    PERF_PHASE (PH_PREPARE);
 }
 
 /**
@@ -171,56 +303,131 @@ static void prepareIngredients ()
  */
 static void waitForCigarette ()
 {
-    if (semDown (semgid, sh->mutex) == -1) {                                                      /* enter critical region */
-        perror ("error on the up operation for semaphore access (AG)");
-        exit (EXIT_FAILURE);
-    }
+    ORDER_TIMES *t;
 
     /* TODO: insert your code here */
-    sh->fSt.st.agentStat = WAITING_CIG;
-    saveState(nFic, &sh->fSt);
-
-    if (semUp (semgid, sh->mutex) == -1) {                                                        /* leave critical region */
-        perror ("error on the up operation for semaphore access (AG)");
-        exit (EXIT_FAILURE);
-    }
+    __atomic_store_n (&sh->fSt.st.agentStat, WAITING_CIG, __ATOMIC_RELEASE);             /* no other field changes */
+    evRecord (ev, ENT_AGENT, WAITING_CIG);
+    saveStateSnapshot (nFic, &sh->fSt, sh->fStSeq, SEQSLOTS (sh->fSt.nWorkers));
 
     /* TODO: insert your code here */
     if (semDown (semgid, sh->waitCigarette) == -1) {                                                        /* leave critical region */
         perror ("error on the up operation for semaphore access (AG)");
         exit (EXIT_FAILURE);
     }
+    t = &sh->stamp[sh->order % ORDERSLOTS];
+    histoAdd (&sh->wake[WAKE_AGENT], nowNs () - t->done);
+
+    /* the agent, alone, accounts for the stages of the order (its slot is not reused before the next order) */
+    histoAdd (&sh->latency[STAGE_MATCH], t->matched - t->created);
+    histoAdd (&sh->latency[STAGE_DISPATCH], t->rolling - t->matched);
+    histoAdd (&sh->latency[STAGE_ROLL], t->done - t->rolling);
+    histoAdd (&sh->latency[STAGE_TOTAL], t->done - t->created);
+    if (t->done > sh->lastDone) {
+        sh->lastDone = t->done;
+    }
+
+    PERF_PHASE (PH_WAITCIG);
 }
 
 /**
  *  \brief agent closes factory of ingredients
  *
- *  The agent updates state and notifies watchers that the factory is closing. 
+ *  The agent updates state and notifies watchers (or the matcher) and all the workers of every smoker
+ *  that the factory is closing, in a single broadcast operation.
  */
 static void closeFactory ()
 {
-    if (semDown (semgid, sh->mutex) == -1) {                                                      /* enter critical region */
-        perror ("error on the up operation for semaphore access (AG)");
-        exit (EXIT_FAILURE);
-    }
-
     /* TODO: insert your code here */
     /* Fechar a fabrica */
-    sh->fSt.st.agentStat = CLOSING_A; // Agente
-    saveState(nFic, &sh->fSt);
-    sh->fSt.closing = true;
+    ldEntityBegin (sh, ENT_AGENT);
+    __atomic_store_n (&sh->fSt.st.agentStat, CLOSING_A, __ATOMIC_RELEASE); // Agente
+    __atomic_store_n (&sh->fSt.closing, true, __ATOMIC_RELEASE);           /* seen by whoever the broadcast wakes */
+    ldEntityEnd (sh, ENT_AGENT);
+    evRecord (ev, ENT_AGENT, CLOSING_A);
+    saveStateSnapshot (nFic, &sh->fSt, sh->fStSeq, SEQSLOTS (sh->fSt.nWorkers));
+
+    /* TODO: insert your code here */
+    /* one operation (or a few, with many workers) wakes every watcher (or the matcher) and every smoker worker */
+    unsigned int sem[SEMMAXOPS], val[SEMMAXOPS], n = 0;
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                        /* leave critical region */
+    if (sh->matcher) {
+        sem[n] = sh->arrival;
+        val[n++] = 1;
+    }
+    else {
+        for (int i = 0; i < sh->fSt.nIngredients; i++) {
+            sem[n] = sh->ingredient[i];
+            val[n++] = 1;
+        }
+    }
+    for (int w = 0; w < sh->fSt.nSmokers * sh->fSt.nWorkers; w++) {
+        if (n == SEMMAXOPS) {                                      /* as few operations as the kernel allows */
+            if (semUpMany (semgid, n, sem, val) == -1) {
+                perror ("error on the up operation for semaphore access (AG)");
+                exit (EXIT_FAILURE);
+            }
+            n = 0;
+        }
+        sem[n] = sh->wait2Ings[w];
+        val[n++] = 1;
+    }
+    if (semUpMany (semgid, n, sem, val) == -1) {
         perror ("error on the up operation for semaphore access (AG)");
         exit (EXIT_FAILURE);
     }
 
-    /* TODO: insert your code here */
-    for (int i = 0 ; i < sh->fSt.nIngredients ; i++) {
-        if (semUp(semgid, sh->ingredient[i]) == -1) {
+    PERF_PHASE (PH_CLOSE);
+}
+
+/**
+ *  \brief agent saves a checkpoint
+ *
+ *  Once the cigarette of an order is notified, the smoker that rolled it is still smoking. The agent waits
+ *  until every smoker worker (and every watcher) is waiting again, so that no pseudo random generator is in
+ *  use and the state is quiescent, and saves the checkpoint inside every lock domain.
+ *
+ *  \param done number of orders completed
+ */
+static void checkpoint (unsigned int done)
+{
+    bool quiet;
+
+    for (;;) {
+        if (ldEnter (semgid, sh, LK_ALL) == -1) {                                                 /* enter critical region */
+            perror ("error on the down operation for semaphore access (AG)");
+            exit (EXIT_FAILURE);
+        }
+        quiet = true;                             /* acquire loads: the generators of waiting entities are saved */
+        for (int w = 0; !sh->matcher && (w < sh->fSt.nIngredients); w++) {
+            quiet = quiet && (__atomic_load_n (&sh->fSt.st.watcherStat[w], __ATOMIC_ACQUIRE) == WAITING_ING);
+        }
+        for (int s = 0; s < sh->fSt.nSmokers * sh->fSt.nWorkers; s++) {
+            quiet = quiet && (__atomic_load_n (&sh->fSt.st.smokerStat[s], __ATOMIC_ACQUIRE) == WAITING_2ING);
+        }
+        if (quiet && (ckptSave (ck, done, &sh->fSt, rngs, sh->latency) == -1)) {
+            perror ("error on saving a checkpoint (AG)");
+            exit (EXIT_FAILURE);
+        }
+        if (ldLeave (semgid, sh, LK_ALL) == -1) {                                                 /* leave critical region */
             perror ("error on the up operation for semaphore access (AG)");
             exit (EXIT_FAILURE);
         }
+        if (quiet) {
+            break;
+        }
+        sched_yield ();
     }
 }
 
+#ifndef MULTICALL
+/**
+ *  \brief Main program.
+ *
+ *  Stand-alone agent executable.
+ */
+int main (int argc, char *argv[])
+{
+    return agentMain (argc, argv);
+}
+#endif /* MULTICALL */
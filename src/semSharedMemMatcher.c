@@ -0,0 +1,315 @@
+/**
+ *  \file semSharedMemMatcher.c (implementation file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  Synchronization based on semaphores and shared memory.
+ *  Implementation with SVIPC.
+ *
+ *  A single matcher process replaces the watcher processes (one per ingredient).
+ *  It is woken once per complete order and carries out, in a single critical region, the same state
+ *  transitions the watchers of the ingredients of the order would have made.
+ *
+ *  Definition of the operations carried out by the matcher:
+ *     \li waitForOrder
+ *     \li matchOrder
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <string.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "logging.h"
+#include "sharedDataSync.h"
+#include "arena.h"
+#include "semaphore.h"
+#include "sharedMemory.h"
+#include "stats.h"
+#include "eventTrace.h"
+#include "orderDeque.h"
+#include "lockDomain.h"
+#include "seqlock.h"
+#include "perfCounters.h"
+#include "entityMain.h"
+#include "realtime.h"
+
+/** \brief life cycle phases of the matcher (index in the counters report) */
+#define  PH_WAITING       0
+#define  PH_MATCHING      1
+
+/** \brief logging file name */
+static char nFic[51];
+
+/** \brief shared memory block access identifier */
+static int shmid;
+
+/** \brief semaphore set access identifier */
+static int semgid;
+
+/** \brief pointer to shared memory region */
+static SHARED_DATA *sh;
+
+/** \brief state transition buffers of the factory (NULL, if transitions are not recorded) */
+static EVENT_BUF *ev;
+
+/** \brief states taken inside the critical region, written to the log after leaving it */
+static FULL_STAT kept[3*NUMINGREDIENTS];
+
+/** \brief number of kept states */
+static int nKept = 0;
+
+/** \brief matcher waits for a complete order generated by agent */
+static bool waitForOrder ();
+
+/** \brief matcher reserves the ingredients of the order and informs the smoker that can roll cigarette */
+static void matchOrder ();
+
+/**
+ *  \brief Entry point of the matcher (main program of its stand-alone executable).
+ *
+ *  Its role is to generate the life cycle of the matcher, which replaces all the watchers.
+ */
+int matcherMain (int argc, char *argv[])
+{
+    int key;                                            /*access key to shared memory and semaphore set */
+    int factory = 0;                                          /* factory in a multi-tenant region (key/factory) */
+    void *arena;                                                        /* beginning of the shared block */
+    char *tinp;                                                       /* numerical parameters test flag */
+
+    /* validation of command line parameters */
+    if (argc != 4) { 
+        freopen ("error_MT", "a", stderr);
+        fprintf (stderr, "Number of parameters is incorrect!\n");
+        return EXIT_FAILURE;
+    }
+    else { 
+        freopen (argv[3], "w", stderr);
+        setbuf(stderr,NULL);
+    }
+
+    strcpy (nFic, argv[1]);
+    key = (unsigned int) strtol (argv[2], &tinp, 0);
+    if (*tinp == '/') {
+        factory = (int) strtol (tinp + 1, &tinp, 0);
+    }
+    if ((*tinp != '\0') || (factory < 0)) {
+        fprintf (stderr, "Error on the access key communication!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* connection to the semaphore set and the shared memory region and mapping the shared region onto the
+       process address space */
+    if ((semgid = semConnect (key)) == -1) { 
+        perror ("error on connecting to the semaphore set");
+        return EXIT_FAILURE;
+    }
+    if ((shmid = shmemConnect (key)) == -1) { 
+        perror ("error on connecting to the shared memory region");
+        return EXIT_FAILURE;
+    }
+    if (shmemAttach (shmid, &arena) == -1) { 
+        perror ("error on mapping the shared region on the process address space");
+        return EXIT_FAILURE;
+    }
+    if ((sh = arenaFind (arena, SHREGION, NULL)) == NULL) {
+        perror ("error on looking up the shared data");
+        return EXIT_FAILURE;
+    }
+    sh += factory;                                                   /* shared data of the factory */
+    if ((ev = arenaFind (arena, EVREGION, NULL)) != NULL) {                       /* transitions are recorded */
+        ev += factory * ENTSLOTS (sh->fSt.nWorkers);
+    }
+    semStress (sh->stress, HB_MATCHER);                                         /* stress mode, if enabled */
+    semWatch (&sh->blockedOn[HB_MATCHER], &sh->beat[HB_MATCHER]);               /* progress seen by the watchdog */
+
+    /* real-time mode: no page faults once operations start */
+    if (sh->rtLock && (rtLock () == -1)) {
+        perror ("error on locking the process memory");
+        return EXIT_FAILURE;
+    }
+
+    /* announcing the entity is ready and waiting for the start of operations */
+    if (semDown (semgid, sh->ready) == -1) {
+        perror ("error on the down operation for semaphore access (MT)");
+        return EXIT_FAILURE;
+    }
+    if (semWaitStart (semgid) == -1) {
+        perror ("error on waiting for the start of operations (MT)");
+        return EXIT_FAILURE;
+    }
+
+    /* counters of the life cycle phases (only when built with PERFCOUNTERS) */
+    PERF_OPEN ("matcher", -1, 2, "waitForOrder", "matchOrder");
+
+    /* simulation of the life cycle of the matcher */
+    while (waitForOrder ()) {
+        matchOrder ();
+    }
+
+    PERF_REPORT ();
+
+    if (semUp (semgid, sh->exited) == -1) {                                     /* the launcher reaps the process */
+        perror ("error on the up operation for semaphore access (MT)");
+        return EXIT_FAILURE;
+    }
+
+    /* unmapping the shared region off the process address space */
+    if (shmemDettach (arena) == -1) {
+        perror ("error on unmapping the shared region off the process address space");
+        return EXIT_FAILURE;;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ *  \brief matcher keeps a copy of the current state
+ *
+ *  Called after each transition (inside the critical region when the inventory changes), so that every
+ *  intermediate transition can still be logged without doing file I/O while holding the mutex. The log is held
+ *  from before the transitions until the kept states are written, so that they are not recorded after newer ones. The states of
+ *  the agent and of the smoker workers are copied consistently with their own (lock free) transitions.
+ */
+static void keepState ()
+{
+    /* the domains are held by the matcher itself, only the lock free transitions of the others may overlap */
+    seqReadAll (&sh->fStSeq[SEQ_ENTITY (0)], ENTSLOTS (sh->fSt.nWorkers), &kept[nKept++], &sh->fSt, sizeof (FULL_STAT));
+}
+
+/**
+ *  \brief matcher writes the kept states to the log
+ *
+ *  Called after leaving the critical region; releases the log.
+ */
+static void flushStates ()
+{
+    for (int k = 0; k < nKept; k++) {
+        saveState (nFic, &kept[k]);
+    }
+    nKept = 0;
+    releaseLog ();
+}
+
+/**
+ *  \brief matcher waits for a complete order generated by agent
+ *
+ *  Matcher waits for the notification of the agent, then checks if agent is closing.
+ *  If agent is closing, the state of every watcher is updated (the workers of every smoker are woken up
+ *  by the agent itself, in the same operation that woke the matcher).
+ *  The internal state should be saved.
+ *
+ *  \return false if closing; true if not closing
+ */
+static bool waitForOrder ()
+{
+    bool ret = true;
+
+    if (semDown (semgid, sh->arrival) == -1) {
+        perror ("error on the down operation for semaphore access (MT)");
+        exit (EXIT_FAILURE);
+    }
+
+    holdLog (nFic);
+    if (__atomic_load_n (&sh->fSt.closing, __ATOMIC_ACQUIRE)) {             /* only the states of the watchers change */
+        for (int i = 0; i < sh->fSt.nIngredients; i++) {
+            __atomic_store_n (&sh->fSt.st.watcherStat[i], CLOSING_W, __ATOMIC_RELEASE);
+            evRecord (ev, ENT_WATCHER (i), CLOSING_W);
+            keepState ();
+        }
+        ret = false;
+    }
+    flushStates ();
+
+    PERF_PHASE (PH_WAITING);
+    return ret;
+}
+
+/**
+ *  \brief matcher reserves the ingredients of the order and informs the smoker that can roll cigarette
+ *
+ *  For each ingredient on the table not yet reserved, the watcher of that ingredient goes through
+ *  UPDATING (and INFORMING, when the reservation completes a cigarette) and back to WAITING_ING,
+ *  every transition being saved as the watcher would.
+ *  The order is pushed onto the deque of one of the workers of the smoker, who is then woken up.
+ */
+static void matchOrder ()
+{
+    int workerReady = -1;                                       /* worker the order is routed to (-1: none) */
+
+    holdLog (nFic);                                              /* before the domains (lock order: log, domains) */
+    if (ldEnter (semgid, sh, LK_INVENTORY | LK_DISPATCH) == -1) {                                 /* enter critical region */
+        perror ("error on the down operation for semaphore access (MT)");
+        exit (EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < sh->fSt.nIngredients; i++) {
+        if (sh->fSt.ingredients[i] <= sh->fSt.reserved[i]) {
+            continue;
+        }
+
+        __atomic_store_n (&sh->fSt.st.watcherStat[i], UPDATING, __ATOMIC_RELEASE);
+        evRecord (ev, ENT_WATCHER (i), UPDATING);
+        keepState ();
+        sh->fSt.reserved[i] += 1;
+
+        int nReserved = 0, smoker = -1;
+        for (int j = 0; j < sh->fSt.nIngredients; j++) {
+            if (sh->fSt.reserved[j] > 0) {
+                nReserved += 1;
+            }
+            else smoker = j;
+        }
+
+        if (nReserved == 2) {
+            __atomic_store_n (&sh->fSt.st.watcherStat[i], INFORMING, __ATOMIC_RELEASE);
+            evRecord (ev, ENT_WATCHER (i), INFORMING);
+            keepState ();
+            for (int j = 0; j < sh->fSt.nIngredients; j++) {
+                sh->fSt.reserved[j] = 0;
+            }
+            if ((workerReady = dqPush (sh, smoker, sh->order)) == -1) {
+                fprintf (stderr, "order deque overflow (MT)\n");
+                exit (EXIT_FAILURE);
+            }
+            sh->stamp[sh->order % ORDERSLOTS].matched = nowNs ();
+            __atomic_store_n (&sh->stamp[sh->order % ORDERSLOTS].posted, 0, __ATOMIC_RELAXED);
+        }
+
+        __atomic_store_n (&sh->fSt.st.watcherStat[i], WAITING_ING, __ATOMIC_RELEASE);
+        evRecord (ev, ENT_WATCHER (i), WAITING_ING);
+        keepState ();
+    }
+
+    if (ldLeave (semgid, sh, LK_INVENTORY | LK_DISPATCH) == -1) {                                  /* exit critical region */
+        perror ("error on the up operation for semaphore access (MT)");
+        exit (EXIT_FAILURE);
+    }
+    flushStates ();
+
+    if (workerReady >= 0) {
+        __atomic_store_n (&sh->stamp[sh->order % ORDERSLOTS].posted, nowNs (), __ATOMIC_RELAXED);
+    }
+    if ((workerReady >= 0) && (semUp (semgid, sh->wait2Ings[workerReady]) == -1)) {
+        perror ("error on the up operation for semaphore access (MT)");
+        exit (EXIT_FAILURE);
+    }
+
+    PERF_PHASE (PH_MATCHING);
+}
+
+#ifndef MULTICALL
+/**
+ *  \brief Main program.
+ *
+ *  Stand-alone matcher executable.
+ */
+int main (int argc, char *argv[])
+{
+    return matcherMain (argc, argv);
+}
+#endif /* MULTICALL */
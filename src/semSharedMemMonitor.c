@@ -0,0 +1,169 @@
+/**
+ *  \file semSharedMemMonitor.c (implementation file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  Live monitor of a running simulation.
+ *
+ *  The monitor maps the shared region read only and samples the full state of the problem at a fixed
+ *  rate, without ever entering the critical region, so watching a run does not slow it down.
+ *  The state of every entity, the inventory, the cigarettes smoked and the throughput are shown.
+ *  The monitor ends when the shared region is destroyed by the launcher.
+ *
+ *  Upon execution, the following parameters are accepted:
+ *    \li <tt>-r rate</tt>: number of samples per second (default 4)
+ *    \li <tt>-k key</tt>: access key to the shared memory (default: the one used by the launcher in the
+ *        current directory)
+ *    \li <tt>-f factory</tt>: factory shown, when the launcher runs several of them (default 0).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "sharedDataSync.h"
+#include "arena.h"
+#include "sharedMemory.h"
+#include "stats.h"
+#include "eventTrace.h"
+#include "seqlock.h"
+
+/**
+ *  \brief Printing a sample of the full state.
+ *
+ *  \param fSt sample of the full state
+ *  \param rate cigarettes per second since the previous sample
+ *  \param avg cigarettes per second since the first sample
+ */
+static void show (FULL_STAT *fSt, double rate, double avg)
+{
+    int total = 0;
+    int nWorkers = fSt->nWorkers;
+
+    if ((nWorkers < 1) || (nWorkers > MAXWORKERS))                                 /* region not yet initialized */
+       return;
+    if (isatty (STDOUT_FILENO))
+       printf ("\033[H\033[J");
+
+    printf ("Smokers - live monitor\n\n");
+    printf ("agent       %-12s\n", evStateName (ENT_AGENT, fSt->st.agentStat));
+    for (int w = 0; w < fSt->nIngredients; w++) {
+        printf ("watcher %-3d %-12s  inventory %4d  reserved %4d\n", w,
+                evStateName (ENT_WATCHER (w), fSt->st.watcherStat[w]), fSt->ingredients[w], fSt->reserved[w]);
+    }
+    for (int s = 0; s < fSt->nSmokers * nWorkers; s++) {
+        printf ("smoker %2d.%-2d %-12s  cigarettes %8d\n", s / nWorkers, s % nWorkers,
+                evStateName (ENT_SMOKER (s), fSt->st.smokerStat[s]), fSt->nCigarettes[s]);
+        total += fSt->nCigarettes[s];
+    }
+    printf ("\norders %d / %d   cigarettes/s %.1f (average %.1f)%s\n", total, fSt->nOrders, rate, avg,
+            fSt->closing ? "   closing" : "");
+    fflush (stdout);
+}
+
+/**
+ *  \brief Main program.
+ *
+ *  Its role is to sample the shared region until it is destroyed.
+ */
+int main (int argc, char *argv[])
+{
+    int key = -1;                                                          /* access key to shared memory */
+    double rate = 4.0;                                                                /* samples per second */
+    int shmid;                                                              /* shared memory access identifier */
+    void *arena;                                                               /* pointer to shared memory region */
+    SHARED_DATA *sh;                                                        /* pointer to the shared data region */
+    size_t len;                                                                /* length of the shared data region */
+    unsigned int factory = 0;                                       /* factory in a multi-tenant region */
+    FULL_STAT fSt;                                                                            /* state sample */
+    struct timespec period;                                                            /* sampling period */
+    uint64_t t0, tPrev, t;                                                           /* sampling times (ns) */
+    int cig0 = 0, cigPrev = 0, cig;                                                  /* cigarettes smoked */
+    char *tinp;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "r:k:f:")) != -1) {
+        switch (opt) {
+            case 'r': rate = strtod (optarg, &tinp);
+                      if ((*tinp != '\0') || (rate <= 0.0)) {
+                          fprintf (stderr, "Rate must be a positive real!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'k': key = (int) strtol (optarg, &tinp, 0);
+                      if (*tinp != '\0') {
+                          fprintf (stderr, "Error on the access key!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'f': factory = (unsigned int) strtoul (optarg, &tinp, 0);
+                      if (*tinp != '\0') {
+                          fprintf (stderr, "Error on the factory!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            default:  fprintf (stderr, "Usage: %s [-r rate] [-k key] [-f factory]\n", argv[0]);
+                      exit (EXIT_FAILURE);
+        }
+    }
+    if ((key == -1) && ((key = ftok (".", 'a')) == -1)) {
+        perror ("error on generating the key");
+        exit (EXIT_FAILURE);
+    }
+
+    /* mapping the shared region read only */
+    if ((shmid = shmemConnect (key)) == -1) {
+        perror ("error on connecting to the shared memory region");
+        exit (EXIT_FAILURE);
+    }
+    if (shmemAttachReadOnly (shmid, &arena) == -1) {
+        perror ("error on mapping the shared region on the process address space");
+        exit (EXIT_FAILURE);
+    }
+    if ((sh = arenaFind (arena, SHREGION, &len)) == NULL) {
+        perror ("error on looking up the shared data");
+        exit (EXIT_FAILURE);
+    }
+    if (factory >= len / sizeof (SHARED_DATA)) {
+        fprintf (stderr, "There are only %zu factories!\n", len / sizeof (SHARED_DATA));
+        exit (EXIT_FAILURE);
+    }
+    sh += factory;
+
+    period.tv_sec = (time_t) (1.0 / rate);
+    period.tv_nsec = (long) ((1.0 / rate - period.tv_sec) * 1e9);
+    t0 = tPrev = nowNs ();
+    for (bool first = true; ; first = false) {
+        seqReadAll (sh->fStSeq, SEQSLOTS (sh->fSt.nWorkers), &fSt, &sh->fSt, sizeof (FULL_STAT)); /* consistent sample, no lock */
+        t = nowNs ();
+        cig = 0;
+        for (int s = 0; (s < fSt.nSmokers * fSt.nWorkers) && (s < NUMSMOKERS * MAXWORKERS); s++) {
+            cig += fSt.nCigarettes[s];
+        }
+        if (first) {
+            cig0 = cigPrev = cig;
+        }
+        show (&fSt, (t > tPrev) ? (cig - cigPrev) * 1e9 / (t - tPrev) : 0.0,
+                    (t > t0) ? (cig - cig0) * 1e9 / (t - t0) : 0.0);
+        tPrev = t;
+        cigPrev = cig;
+
+        if (shmemConnect (key) != shmid)                                   /* the launcher destroyed the region */
+           break;
+        nanosleep (&period, NULL);
+    }
+
+    if (shmemDettach (arena) == -1) {
+        perror ("error on unmapping the shared region off the process address space");
+        exit (EXIT_FAILURE);
+    }
+
+    return EXIT_SUCCESS;
+}
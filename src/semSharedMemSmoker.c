@@ -6,6 +6,9 @@
  *  Synchronization based on semaphores and shared memory.
  *  Implementation with SVIPC.
  *
+ *  Each smoker is served by a pool of workers, each one running in its own process.
+ *  Ready orders are pushed by the watchers onto per-worker deques; idle workers steal from busy peers.
+ *
  *  Definition of the operations carried out by the smokers:
  *     \li waitForIngredients
  *     \li rollingCigarette
@@ -20,14 +23,31 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <string.h>
+#include <errno.h>
 #include <math.h>
 
 #include "probConst.h"
 #include "probDataStruct.h"
 #include "logging.h"
 #include "sharedDataSync.h"
+#include "arena.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
+#include "stats.h"
+#include "eventTrace.h"
+#include "lockDomain.h"
+#include "perfCounters.h"
+#include "orderDeque.h"
+#include "prng.h"
+#include "trace.h"
+#include "entityMain.h"
+#include "timing.h"
+#include "realtime.h"
+
+/** \brief life cycle phases of the smoker worker (index in the counters report) */
+#define  PH_WAITING       0
+#define  PH_ROLLING       1
+#define  PH_SMOKING       2
 
 /** \brief logging file name */
 static char nFic[51];
@@ -41,19 +61,46 @@ static int semgid;
 /** \brief pointer to shared memory region */
 static SHARED_DATA *sh;
 
+/** \brief state transition buffers of the factory (NULL, if transitions are not recorded) */
+static EVENT_BUF *ev;
+
+/** \brief id of the order being served by this worker */
+static unsigned int curOrder;
+
+/** \brief pseudo random generator of this worker (in the shared region, so it can be checkpointed) */
+static PRNG *rng;
+
+/** \brief flag set when the durations are replayed from a trace */
+static bool timed = false;
+
+/** \brief mapped order trace */
+static TRACE trc;
+
+/** \brief time past the deadline of the sleeps of this worker (ns) */
+static HISTO sleepErr;
+
+/** \brief wake-up latency of this worker (ns) */
+static HISTO wakeLat;
+
+/** \brief time this worker woke up for the order being served (ns) */
+static unsigned long long wakeNs;
+
 static bool waitForIngredients (int id);
 static void rollingCigarette (int id);
 static void smoke (int id);
 
 
 /**
- *  \brief Main program.
+ *  \brief Entry point of the smoker (main program of its stand-alone executable).
  *
  *  Its role is to generate the life cycle of one of intervening entities in the problem: the smoker.
  */
-int main (int argc, char *argv[])
+int smokerMain (int argc, char *argv[])
 {
     int key;                                         /*access key to shared memory and semaphore set */
+    int factory = 0;                                          /* factory in a multi-tenant region (key/factory) */
+    void *arena;                                                        /* beginning of the shared block */
+    RNG_SLOT *rngs;                                           /* pseudo random generators of the region */
     char *tinp;                                                    /* numerical parameters test flag */
     int n;
 
@@ -69,13 +116,16 @@ int main (int argc, char *argv[])
     }
 
     n = (unsigned int) strtol (argv[1], &tinp, 0);
-    if ((*tinp != '\0') || (n >= NUMSMOKERS )) { 
+    if ((*tinp != '\0') || (n >= NUMSMOKERS * MAXWORKERS)) { 
         fprintf (stderr, "Smoker process identification is wrong!\n");
         return EXIT_FAILURE;
     }
     strcpy (nFic, argv[2]);
     key = (unsigned int) strtol (argv[3], &tinp, 0);
-    if (*tinp != '\0') { 
+    if (*tinp == '/') {
+        factory = (int) strtol (tinp + 1, &tinp, 0);
+    }
+    if ((*tinp != '\0') || (factory < 0)) {
         fprintf (stderr, "Error on the access key communication!\n");
         return EXIT_FAILURE;
     }
@@ -90,14 +140,72 @@ int main (int argc, char *argv[])
         perror ("error on connecting to the shared memory region");
         return EXIT_FAILURE;
     }
-    if (shmemAttach (shmid, (void **) &sh) == -1) { 
+    if (shmemAttach (shmid, &arena) == -1) { 
         perror ("error on mapping the shared region on the process address space");
         return EXIT_FAILURE;
     }
+    if ((sh = arenaFind (arena, SHREGION, NULL)) == NULL) {
+        perror ("error on looking up the shared data");
+        return EXIT_FAILURE;
+    }
+    sh += factory;                                                   /* shared data of the factory */
+    if ((ev = arenaFind (arena, EVREGION, NULL)) != NULL) {                       /* transitions are recorded */
+        ev += factory * ENTSLOTS (sh->fSt.nWorkers);
+    }
+    if (n >= sh->fSt.nSmokers * sh->fSt.nWorkers) {
+        fprintf (stderr, "Smoker process identification is wrong!\n");
+        return EXIT_FAILURE;
+    }
+    semStress (sh->stress, ENT_SMOKER (n));                                     /* stress mode, if enabled */
+    semWatch (&sh->blockedOn[ENT_SMOKER (n)], &sh->beat[ENT_SMOKER (n)]);       /* progress seen by the watchdog */
 
-    /* initialize random generator */
-    srandom ((unsigned int) getpid ());                                                 
+    /* initialize random generator (stream 1 + worker index belongs to the smoker workers), unless it was
+       restored from a checkpoint */
+    if ((rngs = arenaFind (arena, RNGREGION, NULL)) == NULL) {
+        perror ("error on looking up the random generators");
+        return EXIT_FAILURE;
+    }
+    rng = &rngs[factory * NUMENTITIES + ENT_SMOKER (n)].g;
+    if (sh->firstOrder == 0) {
+        prngSeed (rng, sh->seed, 1 + n);
+    }
 
+    /* precise sleeps of the rolling and smoking durations */
+    if (tmInit (sh->spinNs) == -1) {
+        perror ("error on setting the timer slack");
+        return EXIT_FAILURE;
+    }
+
+    /* mapping the order trace, only needed if it carries durations */
+    if (sh->trace[0] != '\0') {
+        if (traceOpen (sh->trace, &trc) == -1) {
+            perror ("error on mapping the trace file");
+            return EXIT_FAILURE;
+        }
+        if (!(trc.hdr->flags & TRACEDURATIONS)) {
+            traceClose (&trc);
+        }
+        else timed = true;
+    }
+
+    /* real-time mode: no page faults once operations start */
+    if (sh->rtLock && (rtLock () == -1)) {
+        perror ("error on locking the process memory");
+        return EXIT_FAILURE;
+    }
+
+    /* announcing the entity is ready and waiting for the start of operations */
+    if (semDown (semgid, sh->ready) == -1) {
+        perror ("error on the down operation for semaphore access (SM)");
+        return EXIT_FAILURE;
+    }
+    if (semWaitStart (semgid) == -1) {
+        perror ("error on waiting for the start of operations (SM)");
+        return EXIT_FAILURE;
+    }
+
+    /* counters of the life cycle phases (only when built with PERFCOUNTERS) */
+    PERF_OPEN ("smoker", n, 3, "waitForIngredients", "rollingCigarette", "smoke");
 
     /* simulation of the life cycle of the smoker */
     while(waitForIngredients(n)) {
@@ -105,8 +213,19 @@ int main (int argc, char *argv[])
         smoke(n);
     }
 
+    if (timed) {
+        traceClose (&trc);
+    }
+
+    PERF_REPORT ();
+
+    if (semUp (semgid, sh->exited) == -1) {                                     /* the launcher reaps the process */
+        perror ("error on the up operation for semaphore access (SM)");
+        return EXIT_FAILURE;
+    }
+
     /* unmapping the shared region off the process address space */
-    if (shmemDettach (sh) == -1) {
+    if (shmemDettach (arena) == -1) {
         perror ("error on unmapping the shared region off the process address space");
         return EXIT_FAILURE;;
     }
@@ -123,48 +242,37 @@ int main (int argc, char *argv[])
  */
 static double normalRand(double stddev)
 {
-   int i;
-
-   double r=0.0;
-   for (i=0;i<12;i++) {
-       r += random()/(RAND_MAX+1.0);
-   }
-   r -= 6.0;
-
-   return r*stddev;
+   return prngNormal(rng)*stddev;
 }
 
 /**
  *  \brief smoker waits for the 2 ingredients he does not have
  *
  *  smoker updates state and waits for watcher notification to proceed to roll cigarette.
+ *  Each worker waits on its own semaphore, which is raised for each order pushed onto its deque; a worker
+ *  whose deque is empty may first steal the oldest order of a busier peer, taking over its notification.
  *  After the notification, smoker should update the inventory of ingredients.
  *  It may also happen that watcher will notify smoker not because ingredients are available 
  *  but because the factory is closing. In this case, state should be updated and  the function 
  *  should return false;  
+ *  Pending orders are always served before closing.
  *
- *  \param id smoker id, that is related to the ingredient that the smoker holds (see HAVE* constants in probConst.h)
+ *  \param id smoker worker id; the smoker it belongs to is related to the ingredient that the smoker holds
+ *            (see HAVE* constants in probConst.h)
  *
  *  \ret true if ingredients available; false if closing
  */
 static bool waitForIngredients (int id)
 {
     bool ret = true;
-
-    if (semDown (semgid, sh->mutex) == -1)  {                                                     /* enter critical region: 1 processo por vez*/
-        perror ("error on the up operation for semaphore access (SM)");
-        exit (EXIT_FAILURE);
-    }
+    bool stolen = false;                                               /* order taken from a peer's deque */
+    int victim;
 
     /* TODO: insert your code here */
     /* Esperando pelos ingredientes*/
-    sh->fSt.st.smokerStat[id] = WAITING_2ING;
-    saveState(nFic, &sh->fSt);
-
-    if (semUp (semgid, sh->mutex) == -1) {                                                         /* exit critical region */
-        perror ("error on the down operation for semaphore access (SM)");
-        exit (EXIT_FAILURE);
-    }
+    __atomic_store_n (&sh->fSt.st.smokerStat[id], WAITING_2ING, __ATOMIC_RELEASE);      /* no other field changes */
+    evRecord (ev, ENT_SMOKER (id), WAITING_2ING);
+    saveStateSnapshot (nFic, &sh->fSt, sh->fStSeq, SEQSLOTS (sh->fSt.nWorkers));
 
 // size crasha no meio
 //    size_t n_smokers = sizeof(smokers_ids) / sizeof(smokers_ids[0]);
@@ -175,114 +283,169 @@ static bool waitForIngredients (int id)
 //        }
 //    }
 
+    if (sh->fSt.nWorkers > 1) {
+        if (ldEnter (semgid, sh, LK_DISPATCH) == -1) {                                            /* enter critical region */
+            perror ("error on the up operation for semaphore access (SM)");
+            exit (EXIT_FAILURE);
+        }
+        if ((victim = dqVictim (sh, id)) >= 0) {
+            if (semTryDown (semgid, sh->wait2Ings[victim]) == 0) {
+                stolen = dqTake (sh, victim, &curOrder);
+            }
+            else if (errno != EAGAIN) {
+                perror ("error on the down operation for semaphore access (SM)");
+                exit (EXIT_FAILURE);
+            }
+        }
+        if (ldLeave (semgid, sh, LK_DISPATCH) == -1) {                                             /* exit critical region */
+            perror ("error on the down operation for semaphore access (SM)");
+            exit (EXIT_FAILURE);
+        }
+        if (stolen) {                                                  /* no wake-up to account for */
+            PERF_PHASE (PH_WAITING);
+            return true;
+        }
+    }
+
     if (semDown(semgid, sh->wait2Ings[id]) == -1) {
         perror ("error on the down operation for semaphore access (SM)");
         exit (EXIT_FAILURE);
     }
+    wakeNs = nowNs ();
 
-    if (semDown (semgid, sh->mutex) == -1)  {                                                     /* enter critical region */
+    if (ldEnter (semgid, sh, LK_DISPATCH) == -1) {                                                /* enter critical region */
         perror ("error on the up operation for semaphore access (SM)");
         exit (EXIT_FAILURE);
     }
 
     /* TODO: insert your code here */
-    if (sh->fSt.closing) {
-        sh->fSt.st.smokerStat[id] = CLOSING_S;
-        saveState(nFic, &sh->fSt);
+    if (!dqTake(sh, id, &curOrder)) {
+        if (!__atomic_load_n (&sh->fSt.closing, __ATOMIC_ACQUIRE)) {
+            fprintf (stderr, "woken up without pending orders (SM)\n");
+            exit (EXIT_FAILURE);
+        }
+        __atomic_store_n (&sh->fSt.st.smokerStat[id], CLOSING_S, __ATOMIC_RELEASE);
+        evRecord (ev, ENT_SMOKER (id), CLOSING_S);
+        histoMerge (&sh->sleepError, &sleepErr);                       /* accounted for once, when closing */
+        histoMerge (&sh->wake[WAKE_SMOKER], &wakeLat);
         ret = false; // \ret true if ingredients available; false if closing
     }
+    else {
+        unsigned long long posted = __atomic_load_n (&sh->stamp[curOrder % ORDERSLOTS].posted, __ATOMIC_RELAXED);
+        if ((posted != 0) && (posted < wakeNs)) {
+            histoAdd (&wakeLat, wakeNs - posted);
+        }
+    }
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                         /* exit critical region */
+    if (ldLeave (semgid, sh, LK_DISPATCH) == -1) {                                                 /* exit critical region */
         perror ("error on the down operation for semaphore access (SM)");
         exit (EXIT_FAILURE);
     }
+    if (!ret) {                                                       /* closing state is logged outside the region */
+        saveStateSnapshot (nFic, &sh->fSt, sh->fStSeq, SEQSLOTS (sh->fSt.nWorkers));
+    }
 
+    PERF_PHASE (PH_WAITING);
     return ret;
 }
 
 /**
  *  \brief smoker rolls cigarette
  *
- *  The smoker updates state and takes some time to roll the cigarette.
+ *  The smoker updates state and takes some time to roll the cigarette (taken from the trace, if it carries durations).
  *  after completing the cigarette, the smoker should notify the agent.
  *
- *  \param id smoker id
+ *  \param id smoker worker id
  */
 static void rollingCigarette (int id)
 {
-    double rollingTime = 100.0 + normalRand(30.0);
+    double rollingTime, smokingTime;
+
+    if (!(timed && traceDurations (&trc, curOrder, &rollingTime, &smokingTime))) {
+        rollingTime = 100.0 + normalRand(30.0);
+    }
 
-    if (semDown (semgid, sh->mutex) == -1)  {                                                     /* enter critical region */
+    if (ldEnter (semgid, sh, LK_INVENTORY) == -1) {                                               /* enter critical region */
         perror ("error on the up operation for semaphore access (SM)");
         exit (EXIT_FAILURE);
     }
 
     /* TODO: insert your code here */
-    sh->fSt.st.smokerStat[id] = ROLLING;
+    __atomic_store_n (&sh->fSt.st.smokerStat[id], ROLLING, __ATOMIC_RELEASE);
+    evRecord (ev, ENT_SMOKER (id), ROLLING);
+    sh->stamp[curOrder % ORDERSLOTS].rolling = nowNs ();
 
     // Usando os ingredientes
     for (int i = 0 ; i < NUMINGREDIENTS ; i++) {
         sh->fSt.ingredients[i] = 0;
     }
 
-    saveState(nFic, &sh->fSt);
-
-    if (semUp (semgid, sh->mutex) == -1) {                                                         /* exit critical region */
+    if (ldLeave (semgid, sh, LK_INVENTORY) == -1) {                                                /* exit critical region */
         perror ("error on the down operation for semaphore access (SM)");
         exit (EXIT_FAILURE);
     }
+    saveStateSnapshot (nFic, &sh->fSt, sh->fStSeq, SEQSLOTS (sh->fSt.nWorkers));
     
     /* TODO: insert your code here */
+    rollingTime *= sh->timeScale;
     if (rollingTime > 0) {
-        usleep(rollingTime);
+        histoAdd (&sleepErr, tmSleep (rollingTime));
     }
 
+    /* the agent accounts for the stages of the order once notified */
+    sh->stamp[curOrder % ORDERSLOTS].done = nowNs ();
+
     if (semUp(semgid, sh->waitCigarette) == -1) {
         perror ("error on the down operation for semaphore access (SM)");
         exit (EXIT_FAILURE);
     }
 
+    PERF_PHASE (PH_ROLLING);
+
 }
 
 /**
  *  \brief smoker smokes
  *
  *  The smoker updates state and the number of cigarretes already smoked and 
- *  takes some time to smoke the cigarette
+ *  takes some time to smoke the cigarette (taken from the trace, if it carries durations)
  *
- *  \param id smoker id
+ *  \param id smoker worker id
  */
 static void smoke(int id)
 {
 
-    double smokingTime = 100.0 + normalRand(30.0);
+    double rollingTime, smokingTime;
 
-    if (semDown (semgid, sh->mutex) == -1)  {                                                     /* enter critical region */
-        perror ("error on the up operation for semaphore access (SM)");
-        exit (EXIT_FAILURE);
+    if (!(timed && traceDurations (&trc, curOrder, &rollingTime, &smokingTime))) {
+        smokingTime = 100.0 + normalRand(30.0);
     }
 
     /* TODO: insert your code here */
-    sh->fSt.st.smokerStat[id] = SMOKING;
-    sh->fSt.nCigarettes[id] += 1;
-    saveState(nFic, &sh->fSt);
-
-    if (semUp (semgid, sh->mutex) == -1) {                                                         /* exit critical region */
-        perror ("error on the down operation for semaphore access (SM)");
-        exit (EXIT_FAILURE);
-    }
+    ldEntityBegin (sh, ENT_SMOKER (id));                              /* no inventory field changes */
+    __atomic_fetch_add (&sh->fSt.nCigarettes[id], 1, __ATOMIC_RELEASE);
+    __atomic_store_n (&sh->fSt.st.smokerStat[id], SMOKING, __ATOMIC_RELEASE);
+    ldEntityEnd (sh, ENT_SMOKER (id));
+    evRecord (ev, ENT_SMOKER (id), SMOKING);
+    saveStateSnapshot (nFic, &sh->fSt, sh->fStSeq, SEQSLOTS (sh->fSt.nWorkers));
 
     /* TODO: insert your code here */
-
+    smokingTime *= sh->timeScale;
     if (smokingTime > 0) {
-        usleep(smokingTime);
-    }
-
-    if (semUp (semgid, sh->mutex) == -1) {                                                         /* exit critical region */
-        perror ("error on the down operation for semaphore access (SM)");
-        exit (EXIT_FAILURE);
+        histoAdd (&sleepErr, tmSleep (smokingTime));
     }
 
+    PERF_PHASE (PH_SMOKING);
 }
 
-
+#ifndef MULTICALL
+/**
+ *  \brief Main program.
+ *
+ *  Stand-alone smoker executable.
+ */
+int main (int argc, char *argv[])
+{
+    return smokerMain (argc, argv);
+}
+#endif /* MULTICALL */
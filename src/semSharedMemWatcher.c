@@ -27,8 +27,21 @@
 #include "probDataStruct.h"
 #include "logging.h"
 #include "sharedDataSync.h"
+#include "arena.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
+#include "stats.h"
+#include "eventTrace.h"
+#include "lockDomain.h"
+#include "perfCounters.h"
+#include "orderDeque.h"
+#include "entityMain.h"
+#include "realtime.h"
+
+/** \brief life cycle phases of the watcher (index in the counters report) */
+#define  PH_WAITING       0
+#define  PH_UPDATING      1
+#define  PH_INFORMING     2
 
 /** \brief logging file name */
 static char nFic[51];
@@ -42,6 +55,9 @@ static int semgid;
 /** \brief pointer to shared memory region */
 static SHARED_DATA *sh;
 
+/** \brief state transition buffers of the factory (NULL, if transitions are not recorded) */
+static EVENT_BUF *ev;
+
 /** \brief watcher waits for ingredient generated by agent */
 static bool waitForIngredient (int id);
 
@@ -52,13 +68,15 @@ static int updateReservations (int id);
 static void informSmoker(int id, int smokerReady);
 
 /**
- *  \brief Main program.
+ *  \brief Entry point of the watcher (main program of its stand-alone executable).
  *
  *  Its role is to generate the life cycle of one of intervening entities in the problem: the watcher.
  */
-int main (int argc, char *argv[])
+int watcherMain (int argc, char *argv[])
 {
     int key;                                            /*access key to shared memory and semaphore set */
+    int factory = 0;                                          /* factory in a multi-tenant region (key/factory) */
+    void *arena;                                                        /* beginning of the shared block */
     char *tinp;                                                       /* numerical parameters test flag */
 
     /* validation of command line parameters */
@@ -79,7 +97,10 @@ int main (int argc, char *argv[])
     }
     strcpy (nFic, argv[2]);
     key = (unsigned int) strtol (argv[3], &tinp, 0);
-    if (*tinp != '\0') {
+    if (*tinp == '/') {
+        factory = (int) strtol (tinp + 1, &tinp, 0);
+    }
+    if ((*tinp != '\0') || (factory < 0)) {
         fprintf (stderr, "Error on the access key communication!\n");
         return EXIT_FAILURE;
     }
@@ -94,13 +115,39 @@ int main (int argc, char *argv[])
         perror ("error on connecting to the shared memory region");
         return EXIT_FAILURE;
     }
-    if (shmemAttach (shmid, (void **) &sh) == -1) { 
+    if (shmemAttach (shmid, &arena) == -1) { 
         perror ("error on mapping the shared region on the process address space");
         return EXIT_FAILURE;
     }
+    if ((sh = arenaFind (arena, SHREGION, NULL)) == NULL) {
+        perror ("error on looking up the shared data");
+        return EXIT_FAILURE;
+    }
+    sh += factory;                                                   /* shared data of the factory */
+    if ((ev = arenaFind (arena, EVREGION, NULL)) != NULL) {                       /* transitions are recorded */
+        ev += factory * ENTSLOTS (sh->fSt.nWorkers);
+    }
+    semStress (sh->stress, ENT_WATCHER (n));                                    /* stress mode, if enabled */
+    semWatch (&sh->blockedOn[ENT_WATCHER (n)], &sh->beat[ENT_WATCHER (n)]);     /* progress seen by the watchdog */
+
+    /* real-time mode: no page faults once operations start */
+    if (sh->rtLock && (rtLock () == -1)) {
+        perror ("error on locking the process memory");
+        return EXIT_FAILURE;
+    }
+
+    /* announcing the entity is ready and waiting for the start of operations */
+    if (semDown (semgid, sh->ready) == -1) {
+        perror ("error on the down operation for semaphore access (WT)");
+        return EXIT_FAILURE;
+    }
+    if (semWaitStart (semgid) == -1) {
+        perror ("error on waiting for the start of operations (WT)");
+        return EXIT_FAILURE;
+    }
 
-    /* initialize random generator */
-    srandom ((unsigned int) getpid ());              
+    /* counters of the life cycle phases (only when built with PERFCOUNTERS) */
+    PERF_OPEN ("watcher", n, 3, "waitForIngredient", "updateReservations", "informSmoker");
 
     /* simulation of the life cycle of the watcher */
     int id = n, smokerReady;
@@ -109,8 +156,15 @@ int main (int argc, char *argv[])
         if(smokerReady>=0) informSmoker(id, smokerReady);
     }
 
+    PERF_REPORT ();
+
+    if (semUp (semgid, sh->exited) == -1) {                                     /* the launcher reaps the process */
+        perror ("error on the up operation for semaphore access (WT)");
+        return EXIT_FAILURE;
+    }
+
     /* unmapping the shared region off the process address space */
-    if (shmemDettach (sh) == -1) {
+    if (shmemDettach (arena) == -1) {
         perror ("error on unmapping the shared region off the process address space");
         return EXIT_FAILURE;;
     }
@@ -122,8 +176,8 @@ int main (int argc, char *argv[])
  *  \brief watcher waits for ingredient generated by agent
  *
  *  Watcher updates state and waits for ingredient from agent, then checks agent is closing.
- *  If agent is closing, watcher should update state again and inform the smoker that holds 
- *  the ingredient of the watcher so that it can terminate.
+ *  If agent is closing, watcher should update state again (the smokers are woken up by the agent
+ *  itself, in the same operation that woke the watcher).
  *  The internal state should be saved.
  *
  *  \param id watcher id
@@ -134,19 +188,10 @@ static bool waitForIngredient(int id)
 {
     bool ret=true;
     
-    if (semDown (semgid, sh->mutex) == -1)  {                                                     /* enter critical region */
-        perror ("error on the up operation for semaphore access (WT)");
-        exit (EXIT_FAILURE);
-    }
-
     /* TODO: insert your code here */
-    sh->fSt.st.watcherStat[id] = WAITING_ING;
-    saveState(nFic, &sh->fSt);
-
-    if (semUp (semgid, sh->mutex) == -1) {                                                         /* exit critical region */
-        perror ("error on the down operation for semaphore access (WT)");
-        exit (EXIT_FAILURE);
-    }
+    __atomic_store_n (&sh->fSt.st.watcherStat[id], WAITING_ING, __ATOMIC_RELEASE);       /* no other field changes */
+    evRecord (ev, ENT_WATCHER (id), WAITING_ING);
+    saveStateSnapshot (nFic, &sh->fSt, sh->fStSeq, SEQSLOTS (sh->fSt.nWorkers));
 
     /* TODO: insert your code here */
     if (semDown(semgid, sh->ingredient[id]) == -1) {
@@ -154,27 +199,17 @@ static bool waitForIngredient(int id)
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->mutex) == -1)  {                                                     /* enter critical region */
-        perror ("error on the up operation for semaphore access (WT)");
-        exit (EXIT_FAILURE);
-    }
-
     /* TODO: insert your code here */
-    if (sh->fSt.closing) {
-        sh->fSt.st.watcherStat[id] = CLOSING_W;
-        saveState(nFic, &sh->fSt);
-        if (semUp(semgid, sh->wait2Ings[id]) == -1) {
-            perror ("error on the up operation for semaphore access (WT)");
-            exit (EXIT_FAILURE);
-        }
+    if (__atomic_load_n (&sh->fSt.closing, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n (&sh->fSt.st.watcherStat[id], CLOSING_W, __ATOMIC_RELEASE);
+        evRecord (ev, ENT_WATCHER (id), CLOSING_W);                 /* the agent has already woken the smokers */
         ret = false; // \return false if closing; true if not closing
     }
-
-    if (semUp (semgid, sh->mutex) == -1) {                                                         /* exit critical region */
-        perror ("error on the down operation for semaphore access (WT)");
-        exit (EXIT_FAILURE);
+    if (!ret) {
+        saveStateSnapshot (nFic, &sh->fSt, sh->fStSeq, SEQSLOTS (sh->fSt.nWorkers));
     }
 
+    PERF_PHASE (PH_WAITING);
     return ret;
 
 }
@@ -196,14 +231,14 @@ static int updateReservations (int id)
     int numero_ingredientes = 0;
     int smoker;
 
-    if (semDown (semgid, sh->mutex) == -1)  {                                                     /* enter critical region */
+    if (ldEnter (semgid, sh, LK_INVENTORY) == -1) {                                               /* enter critical region */
         perror ("error on the up operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
 
     /* TODO: insert your code here */
-    sh->fSt.st.watcherStat[id] = UPDATING;
-    saveState(nFic, &sh->fSt);
+    __atomic_store_n (&sh->fSt.st.watcherStat[id], UPDATING, __ATOMIC_RELEASE);
+    evRecord (ev, ENT_WATCHER (id), UPDATING);
     sh->fSt.reserved[id] += 1;
 
     for (int i = 0 ; i < sh->fSt.nIngredients ; i++) {
@@ -219,18 +254,21 @@ static int updateReservations (int id)
         ret = smoker;
     }
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                         /* exit critical region */
+    if (ldLeave (semgid, sh, LK_INVENTORY) == -1) {                                                /* exit critical region */
         perror ("error on the down operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
+    saveStateSnapshot (nFic, &sh->fSt, sh->fStSeq, SEQSLOTS (sh->fSt.nWorkers));
 
+    PERF_PHASE (PH_UPDATING);
     return ret;
 }
 
 /**
  *  \brief watcher informs smoker that he can use the available ingredients to roll cigarette
  *
- * The watcher updates its state and notifies smoker that he may start rolling cigarette.  
+ * The watcher updates its state, pushes the order onto the deque of one of the workers of the smoker
+ * and wakes up that worker, which may start rolling cigarette.
  *
  *  \param id watcher id
  *  \param smokerReady  id of smoker that may start rolling
@@ -238,29 +276,52 @@ static int updateReservations (int id)
 
 static void informSmoker (int id, int smokerReady)
 {
+    int worker;                                                            /* worker the order is routed to */
 
-    if (semDown (semgid, sh->mutex) == -1)  {                                                     /* enter critical region */
+    if (ldEnter (semgid, sh, LK_INVENTORY | LK_DISPATCH) == -1) {                                 /* enter critical region */
         perror ("error on the up operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
 
     /* TODO: insert your code here */
-    sh->fSt.st.watcherStat[id] = INFORMING;
-    saveState(nFic, &sh->fSt);
+    __atomic_store_n (&sh->fSt.st.watcherStat[id], INFORMING, __ATOMIC_RELEASE);
+    evRecord (ev, ENT_WATCHER (id), INFORMING);
 
     for (int i = 0 ; i < NUMSMOKERS ; i++) {
         sh->fSt.reserved[i] = 0;
     }
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                         /* exit critical region */
+    if ((worker = dqPush(sh, smokerReady, sh->order)) == -1) {
+        fprintf (stderr, "order deque overflow (WT)\n");
+        exit (EXIT_FAILURE);
+    }
+    sh->stamp[sh->order % ORDERSLOTS].matched = nowNs ();
+    __atomic_store_n (&sh->stamp[sh->order % ORDERSLOTS].posted, 0, __ATOMIC_RELAXED);
+
+    if (ldLeave (semgid, sh, LK_INVENTORY | LK_DISPATCH) == -1) {                                  /* exit critical region */
         perror ("error on the down operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
+    saveStateSnapshot (nFic, &sh->fSt, sh->fStSeq, SEQSLOTS (sh->fSt.nWorkers));
 
     /* TODO: insert your code here */
-    if (semUp(semgid, sh->wait2Ings[smokerReady]) == -1) {
+    __atomic_store_n (&sh->stamp[sh->order % ORDERSLOTS].posted, nowNs (), __ATOMIC_RELAXED);
+    if (semUp(semgid, sh->wait2Ings[worker]) == -1) {
         perror ("error on the down operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
+
+    PERF_PHASE (PH_INFORMING);
 }
 
+#ifndef MULTICALL
+/**
+ *  \brief Main program.
+ *
+ *  Stand-alone watcher executable.
+ */
+int main (int argc, char *argv[])
+{
+    return watcherMain (argc, argv);
+}
+#endif /* MULTICALL */
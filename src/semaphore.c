@@ -7,26 +7,57 @@
  *     \li creation of a set of semaphores
  *     \li connection to a previously created set of semaphores
  *     \li destruction of a previously created set of semaphores
- *     \li signalling start of operations
+ *     \li signalling start of operations and waiting for it
+ *     \li waiting for a semaphore within the set to reach zero
  *     \li <em>down</em> of a semaphore within the set
- *     \li <em>up</em> of a semaphore within the set.
+ *     \li <em>down</em> of a semaphore within the set with a timeout
+ *     \li <em>down</em> of a semaphore within the set, without blocking
+ *     \li <em>down</em> of several semaphores within the set in a single operation
+ *     \li <em>up</em> of a semaphore within the set (by one or several units)
+ *     \li enabling of the schedule perturbation (stress mode)
+ *     \li publishing of the progress of the calling process (heartbeat and blocking semaphore).
  *
  *  \author António Rui Borges - October 1995
  */
 
+#define _GNU_SOURCE                                                                   /* semtimedop */
+
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/sem.h>
 #include <assert.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+
+#include "prng.h"
+#include "semaphore.h"
 
 /** \brief access permission: user r-w */
 #define  MASK           0600
 
+/** \brief longest perturbation sleep (us) */
+#define  STRESSSLEEP    200
+
+/** \brief schedule perturbation enabled */
+static bool stress = false;
+
+/** \brief pseudo random generator of the schedule perturbation */
+static PRNG stressRng;
+
+/** \brief where the blocking semaphore of the calling process is published (NULL if not published) */
+static unsigned int *pBlocked = NULL;
+
+/** \brief where the heartbeat of the calling process is published (NULL if not published) */
+static unsigned long long *pBeat = NULL;
+
 /**
  *  \brief Creation of a set of semaphores.
  *
- *  All semaphores in the set will be in set to <em>red state</em> upon creation.
+ *  All semaphores in the set will be in set to <em>red state</em> upon creation, and the start gate
+ *  (semaphore 0) is closed.
  *  The function fails if there is already a semaphore set with a creation key equal to <tt>key</tt>.
  *
  *  \param key creation key
@@ -38,12 +69,21 @@
 
 int semCreate (int key, unsigned int snum)
 {
-  return semget ((key_t) key, snum+1, MASK | IPC_CREAT | IPC_EXCL);
+  int semgid;                                                                            /* semaphore set identifier */
+  struct sembuf close = { 0, 1, 0 };                                                      /* closing of the start gate */
+
+  if ((semgid = semget ((key_t) key, snum+1, MASK | IPC_CREAT | IPC_EXCL)) == -1)
+     return -1;
+     else if (semop (semgid, &close, 1) == -1)
+             return -1;
+             else return semgid;
 }
 
 /**
  *  \brief Connection to a previously created set of semaphores.
  *
+ *  The start of operations is not awaited here (see semWaitStart), so that a process may announce it is
+ *  ready in between.
  *  The function fails if there is no semaphore set with a creation key equal to <tt>key</tt>.
  *
  *  \param key creation key
@@ -54,14 +94,7 @@ int semCreate (int key, unsigned int snum)
 
 int semConnect (int key)
 {
-  int semgid;                                                                            /* semaphore set identifier */
-  struct sembuf init[2] = {{ 0, -1, 0 }, {0, 1, 0}};                                     /* initialization operation */
-
-  if ((semgid = semget ((key_t) key, 1, MASK)) == -1)
-     return -1;
-     else if (semop (semgid, init, 2) == -1)
-             return -1;
-             else return semgid;
+  return semget ((key_t) key, 1, MASK);
 }
 
 /**
@@ -83,6 +116,8 @@ int semDestroy (int semgid)
 /**
  *  \brief Signalling start of operations upon initialization of shared data structures.
  *
+ *  The start gate is opened: every process waiting in semWaitStart is released by a single operation.
+ *  The gate is a barrier that can be reused by closing it again (<em>up</em> of semaphore 0).
  *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
  *
  *  \param semgid set identifier
@@ -93,9 +128,109 @@ int semDestroy (int semgid)
 
 int semSignal (int semgid)
 {
-  struct sembuf up = { 0, 1, 0 };                                                         /* all around up operation */
+  struct sembuf open = { 0, -1, 0 };                                                    /* opening of the start gate */
+
+  return semop (semgid, &open, 1);
+}
+
+/**
+ *  \brief Waiting for the start of operations.
+ *
+ *  The calling process blocks until the start gate is opened (semSignal).
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semWaitStart (int semgid)
+{
+  struct sembuf zero = { 0, 0, 0 };                                                      /* wait for the gate to open */
 
-  return semop (semgid, &up, 1);
+  return semop (semgid, &zero, 1);
+}
+
+/**
+ *  \brief Waiting for a semaphore within the set to reach zero.
+ *
+ *  Used as a countdown: the semaphore is raised to the number of parties (semUpBy) and each party
+ *  makes a <em>down</em>. The function fails if there is no semaphore set with an identifier equal to
+ *  <tt>semgid</tt>, or if the semaphore did not reach zero within <tt>msec</tt> milliseconds (<tt>errno</tt>
+ *  is then \c EAGAIN).
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param msec timeout (ms), \c 0 waits forever
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semWaitZero (int semgid, unsigned int sindex, unsigned int msec)
+{
+  struct sembuf zero = { 0, 0, 0 };                                                              /* wait for zero */
+  struct timespec t;                                                                                   /* timeout */
+
+  assert(sindex>0);
+  zero.sem_num = (unsigned short) sindex;
+  if (msec == 0)
+     return semop (semgid, &zero, 1);
+  t.tv_sec = msec / 1000;
+  t.tv_nsec = 1000000L * (msec % 1000);
+  return semtimedop (semgid, &zero, 1, &t);
+}
+
+/**
+ *  \brief Schedule perturbation around a semaphore operation.
+ *
+ *  With the perturbation enabled, nothing is done in 3/8 of the calls, the processor is yielded in 1/2 and
+ *  the process sleeps up to STRESSSLEEP us in 1/8. <tt>errno</tt> is preserved.
+ */
+
+static void perturb (void)
+{
+  unsigned int r;                                                                               /* random choice */
+  int err = errno;                                                                   /* errno of the operation */
+  struct timespec t = { 0, 0 };                                                                  /* sleep time */
+
+  if (!stress)
+     return;
+  r = prngBelow (&stressRng, 8);
+  if (r == 7)
+     { t.tv_nsec = 1000L * (1 + prngBelow (&stressRng, STRESSSLEEP));
+       nanosleep (&t, NULL);
+     }
+     else if (r >= 3)
+             sched_yield ();
+  errno = err;
+}
+
+/**
+ *  \brief Semaphore operation, with the progress of the calling process published.
+ *
+ *  \param semgid set identifier
+ *  \param op operations, carried out atomically (the first one is published as the blocking semaphore)
+ *  \param nops number of operations
+ *  \param timeout timeout (NULL waits forever)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+static int watchedOp (int semgid, struct sembuf *op, size_t nops, const struct timespec *timeout)
+{
+  int stat;                                                                                    /* operation status */
+
+  if ((pBlocked != NULL) && (op->sem_op < 0))
+     __atomic_store_n (pBlocked, op->sem_num, __ATOMIC_RELAXED);
+  stat = (timeout == NULL) ? semop (semgid, op, nops) : semtimedop (semgid, op, nops, timeout);
+  if ((pBlocked != NULL) && (op->sem_op < 0))
+     __atomic_store_n (pBlocked, 0, __ATOMIC_RELAXED);
+  if ((pBeat != NULL) && (stat == 0))
+     __atomic_store_n (pBeat, *pBeat + 1, __ATOMIC_RELAXED);
+  return stat;
 }
 
 /**
@@ -113,10 +248,107 @@ int semSignal (int semgid)
 int semDown (int semgid, unsigned int sindex)
 {
   struct sembuf down = { 0, -1, 0 };                                                      /* specific down operation */
+  int stat;                                                                                    /* operation status */
+
+  assert(sindex>0);
+  down.sem_num = (unsigned short) sindex;
+  perturb ();
+  stat = watchedOp (semgid, &down, 1, NULL);
+  perturb ();
+  return stat;
+}
+
+/**
+ *  \brief <em>Down</em> of a semaphore within the set with a timeout.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>, or if the
+ *  semaphore could not be decremented within <tt>msec</tt> milliseconds (<tt>errno</tt> is then \c EAGAIN).
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param msec timeout (ms)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semDownTimed (int semgid, unsigned int sindex, unsigned int msec)
+{
+  struct sembuf down = { 0, -1, 0 };                                                      /* specific down operation */
+  struct timespec t;                                                                                   /* timeout */
+  int stat;                                                                                    /* operation status */
+
+  assert(sindex>0);
+  down.sem_num = (unsigned short) sindex;
+  t.tv_sec = msec / 1000;
+  t.tv_nsec = 1000000L * (msec % 1000);
+  perturb ();
+  stat = watchedOp (semgid, &down, 1, &t);
+  perturb ();
+  return stat;
+}
+
+/**
+ *  \brief <em>Down</em> of a semaphore within the set, without blocking.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>, or if the
+ *  semaphore is zero (<tt>errno</tt> is then \c EAGAIN).
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semTryDown (int semgid, unsigned int sindex)
+{
+  struct sembuf down = { 0, -1, IPC_NOWAIT };                                             /* specific down operation */
+  int stat;                                                                                    /* operation status */
 
   assert(sindex>0);
   down.sem_num = (unsigned short) sindex;
-  return semop (semgid, &down, 1);
+  perturb ();
+  stat = watchedOp (semgid, &down, 1, NULL);
+  perturb ();
+  return stat;
+}
+
+/**
+ *  \brief <em>Down</em> of several semaphores within the set in a single operation.
+ *
+ *  All the <em>downs</em> are carried out atomically by one system call: the calling process is blocked until
+ *  every semaphore can be decremented, and none is decremented before. Several locks are thus taken at once,
+ *  with no lock held while waiting for another. The function fails if there is no semaphore set with an
+ *  identifier equal to <tt>semgid</tt>, or if <tt>n</tt> exceeds SEMMAXOPS.
+ *
+ *  \param semgid set identifier
+ *  \param n number of semaphores
+ *  \param sindex semaphore locations in the set (1 .. snum, all different)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semDownMany (int semgid, unsigned int n, const unsigned int sindex[])
+{
+  struct sembuf down[SEMMAXOPS];                                                        /* multiple down operation */
+  int stat;                                                                                    /* operation status */
+
+  if (n > SEMMAXOPS)
+     { errno = E2BIG;
+       return -1;
+     }
+  for (unsigned int i = 0; i < n; i++)
+  { assert(sindex[i]>0);
+    down[i].sem_num = (unsigned short) sindex[i];
+    down[i].sem_op = -1;
+    down[i].sem_flg = 0;
+  }
+  perturb ();
+  stat = watchedOp (semgid, down, n, NULL);
+  perturb ();
+  return stat;
 }
 
 /**
@@ -134,8 +366,108 @@ int semDown (int semgid, unsigned int sindex)
 int semUp (int semgid, unsigned int sindex)
 {
   struct sembuf up = { 0, 1, 0 };                                                           /* specific up operation */
+  int stat;                                                                                    /* operation status */
 
   assert(sindex>0);
   up.sem_num = (unsigned short) sindex;
-  return semop (semgid, &up, 1);
+  perturb ();
+  stat = watchedOp (semgid, &up, 1, NULL);
+  perturb ();
+  return stat;
+}
+
+/**
+ *  \brief <em>Up</em> of a semaphore within the set by several units in a single operation.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param n number of units
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semUpBy (int semgid, unsigned int sindex, unsigned int n)
+{
+  struct sembuf up = { 0, 1, 0 };                                                         /* multiple up operation */
+
+  assert(sindex>0);
+  up.sem_num = (unsigned short) sindex;
+  up.sem_op = (short) n;
+  return watchedOp (semgid, &up, 1, NULL);
+}
+
+/**
+ *  \brief <em>Up</em> of several semaphores within the set in a single operation.
+ *
+ *  All the <em>ups</em> are carried out atomically by one system call, so the processes blocked on any of
+ *  the semaphores are woken up in one wave (broadcast). The function fails if there is no semaphore set with
+ *  an identifier equal to <tt>semgid</tt>, or if <tt>n</tt> exceeds SEMMAXOPS.
+ *
+ *  \param semgid set identifier
+ *  \param n number of semaphores
+ *  \param sindex semaphore locations in the set (1 .. snum)
+ *  \param val number of units of each <em>up</em>
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semUpMany (int semgid, unsigned int n, const unsigned int sindex[], const unsigned int val[])
+{
+  struct sembuf up[SEMMAXOPS];                                                            /* broadcast operation */
+  int stat;                                                                                    /* operation status */
+
+  if (n > SEMMAXOPS)
+     { errno = E2BIG;
+       return -1;
+     }
+  for (unsigned int i = 0; i < n; i++)
+  { assert(sindex[i]>0);
+    up[i].sem_num = (unsigned short) sindex[i];
+    up[i].sem_op = (short) val[i];
+    up[i].sem_flg = 0;
+  }
+  perturb ();
+  stat = watchedOp (semgid, up, n, NULL);
+  perturb ();
+  return stat;
+}
+
+/**
+ *  \brief Enabling of the schedule perturbation (stress mode).
+ *
+ *  Once enabled, every <em>down</em> and <em>up</em> of the calling process may, before and after the
+ *  operation, yield the processor or sleep for a short random time. The choices are drawn from a
+ *  pseudo random generator seeded with <tt>seed</tt> and <tt>stream</tt>, so a failing schedule can be
+ *  searched for again with the same seed.
+ *
+ *  \param seed perturbation seed (\c 0 disables the perturbation)
+ *  \param stream generator stream (one per process)
+ */
+
+void semStress (unsigned long long seed, unsigned int stream)
+{
+  stress = (seed != 0);
+  if (stress)
+     prngSeed (&stressRng, seed, stream);
+}
+
+/**
+ *  \brief Publishing of the progress of the calling process (heartbeat and blocking semaphore).
+ *
+ *  From then on, every <em>down</em> stores its semaphore location in <tt>*blocked</tt> while it waits, and
+ *  every completed <em>down</em> and <em>up</em> increments <tt>*beat</tt>. Both usually live in shared
+ *  memory, so that a watchdog can tell a wedged process from a busy one.
+ *
+ *  \param blocked pointer to the blocking semaphore location (0 when not blocked)
+ *  \param beat pointer to the heartbeat counter
+ */
+
+void semWatch (unsigned int *blocked, unsigned long long *beat)
+{
+  pBlocked = blocked;
+  pBeat = beat;
 }
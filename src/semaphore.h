@@ -7,9 +7,15 @@
  *     \li creation of a set of semaphores
  *     \li connection to a previously created set of semaphores
  *     \li destruction of a previously created set of semaphores
- *     \li signalling start of operations
+ *     \li signalling start of operations and waiting for it
+ *     \li waiting for a semaphore within the set to reach zero
  *     \li <em>down</em> of a semaphore within the set
- *     \li <em>up</em> of a semaphore within the set.
+ *     \li <em>down</em> of a semaphore within the set with a timeout
+ *     \li <em>down</em> of a semaphore within the set, without blocking
+ *     \li <em>down</em> of several semaphores within the set in a single operation
+ *     \li <em>up</em> of a semaphore within the set (by one or several units)
+ *     \li enabling of the schedule perturbation (stress mode)
+ *     \li publishing of the progress of the calling process (heartbeat and blocking semaphore).
  *
  *  \author António Rui Borges - October 1995
  */
@@ -17,10 +23,14 @@
 #ifndef SEMAPHORE_H_
 #define SEMAPHORE_H_
 
+/** \brief maximum number of semaphores in a single operation (within the SEMOPM limit of every kernel) */
+#define SEMMAXOPS 32
+
 /**
  *  \brief Creation of a set of semaphores.
  *
- *  All semaphores in the set will be in set to <em>red state</em> upon creation.
+ *  All semaphores in the set will be in set to <em>red state</em> upon creation, and the start gate
+ *  (semaphore 0) is closed.
  *  The function fails if there is already a semaphore set with a creation key equal to <tt>key</tt>.
  *
  *  \param key creation key
@@ -35,6 +45,8 @@ extern int semCreate (int key, unsigned int snum);
 /**
  *  \brief Connection to a previously created set of semaphores.
  *
+ *  The start of operations is not awaited here (see semWaitStart), so that a process may announce it is
+ *  ready in between.
  *  The function fails if there is no semaphore set with a creation key equal to <tt>key</tt>.
  *
  *  \param key creation key
@@ -61,6 +73,8 @@ extern int semDestroy (int semgid);
 /**
  *  \brief Signalling start of operations upon initialization of shared data structures.
  *
+ *  The start gate is opened: every process waiting in semWaitStart is released by a single operation.
+ *  The gate is a barrier that can be reused by closing it again (<em>up</em> of semaphore 0).
  *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
  *
  *  \param semgid set identifier
@@ -71,6 +85,38 @@ extern int semDestroy (int semgid);
 
 extern int semSignal (int semgid);
 
+/**
+ *  \brief Waiting for the start of operations.
+ *
+ *  The calling process blocks until the start gate is opened (semSignal).
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semWaitStart (int semgid);
+
+/**
+ *  \brief Waiting for a semaphore within the set to reach zero.
+ *
+ *  Used as a countdown: the semaphore is raised to the number of parties (semUpBy) and each party
+ *  makes a <em>down</em>. The function fails if there is no semaphore set with an identifier equal to
+ *  <tt>semgid</tt>, or if the semaphore did not reach zero within <tt>msec</tt> milliseconds (<tt>errno</tt>
+ *  is then \c EAGAIN).
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param msec timeout (ms), \c 0 waits forever
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semWaitZero (int semgid, unsigned int sindex, unsigned int msec);
+
 /**
  *  \brief <em>Down</em> of a semaphore within the set.
  *
@@ -85,6 +131,55 @@ extern int semSignal (int semgid);
 
 extern int semDown (int semgid, unsigned int sindex);
 
+/**
+ *  \brief <em>Down</em> of a semaphore within the set with a timeout.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>, or if the
+ *  semaphore could not be decremented within <tt>msec</tt> milliseconds (<tt>errno</tt> is then \c EAGAIN).
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param msec timeout (ms)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semDownTimed (int semgid, unsigned int sindex, unsigned int msec);
+
+/**
+ *  \brief <em>Down</em> of a semaphore within the set, without blocking.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>, or if the
+ *  semaphore is zero (<tt>errno</tt> is then \c EAGAIN).
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semTryDown (int semgid, unsigned int sindex);
+
+/**
+ *  \brief <em>Down</em> of several semaphores within the set in a single operation.
+ *
+ *  All the <em>downs</em> are carried out atomically by one system call: the calling process is blocked until
+ *  every semaphore can be decremented, and none is decremented before. Several locks are thus taken at once,
+ *  with no lock held while waiting for another. The function fails if there is no semaphore set with an
+ *  identifier equal to <tt>semgid</tt>, or if <tt>n</tt> exceeds SEMMAXOPS.
+ *
+ *  \param semgid set identifier
+ *  \param n number of semaphores
+ *  \param sindex semaphore locations in the set (1 .. snum, all different)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semDownMany (int semgid, unsigned int n, const unsigned int sindex[]);
+
 /**
  *  \brief <em>Up</em> of a semaphore within the set.
  *
@@ -99,4 +194,64 @@ extern int semDown (int semgid, unsigned int sindex);
 
 extern int semUp (int semgid, unsigned int sindex);
 
+/**
+ *  \brief <em>Up</em> of a semaphore within the set by several units in a single operation.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param n number of units
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semUpBy (int semgid, unsigned int sindex, unsigned int n);
+
+/**
+ *  \brief <em>Up</em> of several semaphores within the set in a single operation.
+ *
+ *  All the <em>ups</em> are carried out atomically by one system call, so the processes blocked on any of
+ *  the semaphores are woken up in one wave (broadcast). The function fails if there is no semaphore set with
+ *  an identifier equal to <tt>semgid</tt>, or if <tt>n</tt> exceeds SEMMAXOPS.
+ *
+ *  \param semgid set identifier
+ *  \param n number of semaphores
+ *  \param sindex semaphore locations in the set (1 .. snum)
+ *  \param val number of units of each <em>up</em>
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semUpMany (int semgid, unsigned int n, const unsigned int sindex[], const unsigned int val[]);
+
+/**
+ *  \brief Enabling of the schedule perturbation (stress mode).
+ *
+ *  Once enabled, every <em>down</em> and <em>up</em> of the calling process may, before and after the
+ *  operation, yield the processor or sleep for a short random time. The choices are drawn from a
+ *  pseudo random generator seeded with <tt>seed</tt> and <tt>stream</tt>, so a failing schedule can be
+ *  searched for again with the same seed.
+ *
+ *  \param seed perturbation seed (\c 0 disables the perturbation)
+ *  \param stream generator stream (one per process)
+ */
+
+extern void semStress (unsigned long long seed, unsigned int stream);
+
+/**
+ *  \brief Publishing of the progress of the calling process (heartbeat and blocking semaphore).
+ *
+ *  From then on, every <em>down</em> stores its semaphore location in <tt>*blocked</tt> while it waits, and
+ *  every completed <em>down</em> and <em>up</em> increments <tt>*beat</tt>. Both usually live in shared
+ *  memory, so that a watchdog can tell a wedged process from a busy one.
+ *
+ *  \param blocked pointer to the blocking semaphore location (0 when not blocked)
+ *  \param beat pointer to the heartbeat counter
+ */
+
+extern void semWatch (unsigned int *blocked, unsigned long long *beat);
+
 #endif /* SEMAPHORE_H_ */
@@ -0,0 +1,113 @@
+/**
+ *  \file seqlock.c (implementation file)
+ *
+ *  \brief Sequence counters for lock free reading of shared data.
+ *
+ *  Writers, which must already be mutually exclusive (inside the critical region), make the counter odd
+ *  before changing the protected data and even again afterwards. Readers copy the data optimistically
+ *  and retry if the counter was odd or changed during the copy, so they never take the mutex.
+ *
+ *  Defined operations:
+ *     \li beginning of a write
+ *     \li end of a write
+ *     \li consistent read (copy) of the protected data
+ *     \li consistent read (copy) of data protected by several counters.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <sched.h>
+
+#include "seqlock.h"
+
+/**
+ *  \brief Beginning of a write of the data protected by a sequence counter.
+ *
+ *  \param seq pointer to the sequence counter
+ */
+void seqWriteBegin (unsigned int *seq)
+{
+    __atomic_store_n (seq, *seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence (__ATOMIC_RELEASE);                   /* odd counter is visible before any data write */
+}
+
+/**
+ *  \brief End of a write of the data protected by a sequence counter.
+ *
+ *  \param seq pointer to the sequence counter
+ */
+void seqWriteEnd (unsigned int *seq)
+{
+    __atomic_store_n (seq, *seq + 1, __ATOMIC_RELEASE);            /* data writes are visible before even counter */
+}
+
+/**
+ *  \brief Consistent read (copy) of the data protected by a sequence counter.
+ *
+ *  The copy is retried until no write overlapped it.
+ *
+ *  \param seq pointer to the sequence counter
+ *  \param dst pointer to the copy
+ *  \param src pointer to the protected data
+ *  \param n size of the protected data (in bytes)
+ *
+ *  \return number of retries
+ */
+unsigned int seqRead (const unsigned int *seq, void *dst, const void *src, size_t n)
+{
+    unsigned int s1, s2, retries = 0;
+
+    for (;;) {
+        s1 = __atomic_load_n (seq, __ATOMIC_ACQUIRE);
+        if ((s1 & 1) == 0) {
+            memcpy (dst, src, n);
+            __atomic_thread_fence (__ATOMIC_ACQUIRE);                    /* data reads complete before re-check */
+            s2 = __atomic_load_n (seq, __ATOMIC_RELAXED);
+            if (s1 == s2)
+               return retries;
+        }
+        retries += 1;
+        sched_yield ();                                            /* writer may have been preempted in the region */
+    }
+}
+
+/**
+ *  \brief Consistent read (copy) of data protected by several sequence counters.
+ *
+ *  Data split into domains, each written under its own lock and counter, is copied as a whole: the copy is
+ *  retried until no write of any domain overlapped it.
+ *
+ *  \param seq sequence counters
+ *  \param nSeq number of sequence counters (up to SEQMAXCOUNTERS)
+ *  \param dst pointer to the copy
+ *  \param src pointer to the protected data
+ *  \param n size of the protected data (in bytes)
+ *
+ *  \return number of retries
+ */
+unsigned int seqReadAll (const unsigned int seq[], unsigned int nSeq, void *dst, const void *src, size_t n)
+{
+    unsigned int s[SEQMAXCOUNTERS], i, retries = 0;
+
+    if (nSeq > SEQMAXCOUNTERS) {
+        nSeq = SEQMAXCOUNTERS;
+    }
+    for (;;) {
+        for (i = 0; i < nSeq; i++) {
+            s[i] = __atomic_load_n (&seq[i], __ATOMIC_ACQUIRE);
+            if ((s[i] & 1) != 0) {
+                break;
+            }
+        }
+        if (i == nSeq) {
+            memcpy (dst, src, n);
+            __atomic_thread_fence (__ATOMIC_ACQUIRE);                    /* data reads complete before re-check */
+            for (i = 0; (i < nSeq) && (__atomic_load_n (&seq[i], __ATOMIC_RELAXED) == s[i]); i++)
+                ;
+            if (i == nSeq)
+               return retries;
+        }
+        retries += 1;
+        sched_yield ();                                            /* writer may have been preempted in the region */
+    }
+}
@@ -0,0 +1,69 @@
+/**
+ *  \file seqlock.h (interface file)
+ *
+ *  \brief Sequence counters for lock free reading of shared data.
+ *
+ *  Writers, which must already be mutually exclusive (inside the critical region), make the counter odd
+ *  before changing the protected data and even again afterwards. Readers copy the data optimistically
+ *  and retry if the counter was odd or changed during the copy, so they never take the mutex.
+ *
+ *  Defined operations:
+ *     \li beginning of a write
+ *     \li end of a write
+ *     \li consistent read (copy) of the protected data
+ *     \li consistent read (copy) of data protected by several counters.
+ */
+
+#ifndef SEQLOCK_H_
+#define SEQLOCK_H_
+
+#include <stddef.h>
+
+/** \brief maximum number of sequence counters of a single read */
+#define SEQMAXCOUNTERS    256
+
+/**
+ *  \brief Beginning of a write of the data protected by a sequence counter.
+ *
+ *  \param seq pointer to the sequence counter
+ */
+extern void seqWriteBegin (unsigned int *seq);
+
+/**
+ *  \brief End of a write of the data protected by a sequence counter.
+ *
+ *  \param seq pointer to the sequence counter
+ */
+extern void seqWriteEnd (unsigned int *seq);
+
+/**
+ *  \brief Consistent read (copy) of the data protected by a sequence counter.
+ *
+ *  The copy is retried until no write overlapped it.
+ *
+ *  \param seq pointer to the sequence counter
+ *  \param dst pointer to the copy
+ *  \param src pointer to the protected data
+ *  \param n size of the protected data (in bytes)
+ *
+ *  \return number of retries
+ */
+extern unsigned int seqRead (const unsigned int *seq, void *dst, const void *src, size_t n);
+
+/**
+ *  \brief Consistent read (copy) of data protected by several sequence counters.
+ *
+ *  Data split into domains, each written under its own lock and counter, is copied as a whole: the copy is
+ *  retried until no write of any domain overlapped it.
+ *
+ *  \param seq sequence counters
+ *  \param nSeq number of sequence counters (up to SEQMAXCOUNTERS)
+ *  \param dst pointer to the copy
+ *  \param src pointer to the protected data
+ *  \param n size of the protected data (in bytes)
+ *
+ *  \return number of retries
+ */
+extern unsigned int seqReadAll (const unsigned int seq[], unsigned int nSeq, void *dst, const void *src, size_t n);
+
+#endif /* SEQLOCK_H_ */
@@ -19,6 +19,60 @@
 
 #include "probConst.h"
 #include "probDataStruct.h"
+#include "stats.h"
+#include "prng.h"
+#include "arena.h"
+
+/* Entity slots of per entity data (the matcher uses the slots of the watchers) */
+
+/** \brief slot of the agent */
+#define ENT_AGENT              0
+/** \brief slot of watcher i */
+#define ENT_WATCHER(i)         (1 + (i))
+/** \brief slot of smoker worker w (index in <tt>fSt.st.smokerStat</tt>) */
+#define ENT_SMOKER(w)          (1 + NUMINGREDIENTS + (w))
+/** \brief number of entity slots */
+#define NUMENTITIES            ENT_SMOKER (NUMSMOKERS * MAXWORKERS)
+/** \brief number of entity slots in use with w workers per smoker */
+#define ENTSLOTS(w)            ENT_SMOKER (NUMSMOKERS * (w))
+/** \brief heartbeat slot of the matcher (heartbeats have a slot per entity process) */
+#define HB_MATCHER             NUMENTITIES
+/** \brief number of heartbeat slots */
+#define NUMBEATS               (NUMENTITIES + 1)
+
+/* Lock domains of the shared data, each protected by its own semaphore and sequence counter:
+     - inventory domain: ingredients, reservations and the order on the table
+     - dispatch domain: order deques of the smoker workers and the statistics merged by them.
+   The states of the entities, the cigarettes of each smoker worker and the closing flag are not in any domain:
+   each word has a single writer, which updates it with a release store (or increment), and is read with an
+   acquire load, so a transition that changes nothing else takes no semaphore at all. A transition that changes
+   several of these words outside any domain (a smoker worker smoking, the agent closing) makes the sequence
+   counter of its entity odd meanwhile, so snapshots validate the domain and the entity counters alike.
+   Lock order: inventory, dispatch. All the domains of a transition are taken in a single semaphore operation
+   (see lockDomain.h), so no process ever holds a domain while waiting for another; a process holding domains
+   never enters again before leaving them. The log file (see logging.h) is never locked while holding a domain:
+   the matcher, which records states kept inside the region, locks it before entering. */
+
+/** \brief index of the inventory domain */
+#define DOM_INVENTORY          0
+/** \brief index of the dispatch domain */
+#define DOM_DISPATCH           1
+/** \brief number of lock domains */
+#define NUMDOMAINS             2
+
+/** \brief sequence counter of entity slot e (the counters of the domains come first) */
+#define SEQ_ENTITY(e)          (NUMDOMAINS + (e))
+/** \brief number of sequence counters */
+#define NUMSEQS                SEQ_ENTITY (NUMENTITIES)
+/** \brief number of sequence counters in use with w workers per smoker */
+#define SEQSLOTS(w)            SEQ_ENTITY (ENTSLOTS (w))
+
+/** \brief set of lock domains: inventory domain */
+#define LK_INVENTORY           (1u << DOM_INVENTORY)
+/** \brief set of lock domains: dispatch domain */
+#define LK_DISPATCH            (1u << DOM_DISPATCH)
+/** \brief set of lock domains: all of them */
+#define LK_ALL                 ((1u << NUMDOMAINS) - 1)
 
 /**
  *  \brief Definition of <em>shared information</em> data type.
@@ -26,25 +80,104 @@
 typedef struct
         { /** \brief full state of the problem */
           FULL_STAT fSt;
+          /** \brief sequence counters of the lock domains and of the entity slots of <tt>fSt</tt> (odd while
+                     being written, see SEQ_ENTITY) */
+          unsigned int fStSeq[NUMSEQS];
+
+          /** \brief id of the order whose ingredients are on the table */
+          unsigned int order;
+          /** \brief order deques of the smoker workers (same layout as <tt>fSt.st.smokerStat</tt>) */
+          DEQUE deque[NUMSMOKERS*MAXWORKERS];
+          /** \brief flag set when a single matcher process replaces the watchers */
+          bool matcher;
+          /** \brief seed of the pseudo random generators of all entities */
+          unsigned long long seed;
+          /** \brief seed of the schedule perturbation of the semaphore operations (0 if disabled) */
+          unsigned long long stress;
+          /** \brief name of the order trace replayed by the agent (empty string, if none) */
+          char trace[256];
+          /** \brief factor applied to rolling and smoking durations (0 disables them) */
+          double timeScale;
+          /** \brief length of the busy wait that ends each rolling and smoking sleep (ns, 0 if none) */
+          unsigned int spinNs;
+          /** \brief name of the checkpoint file written by the agent (empty string, if none) */
+          char ckpt[256];
+          /** \brief number of orders between checkpoints */
+          unsigned int ckptEvery;
+          /** \brief id of the first order (orders completed by the run being resumed) */
+          unsigned int firstOrder;
+          /** \brief flag set when the entities lock their memory (real-time mode) */
+          bool rtLock;
+
+          /** \brief timestamps of the orders in flight (indexed by order id modulo ORDERSLOTS) */
+          ORDER_TIMES stamp[ORDERSLOTS];
+          /** \brief latency of each benchmark stage (ns) */
+          HISTO latency[NUMSTAGES];
+          /** \brief time past the deadline of the rolling and smoking sleeps (ns) */
+          HISTO sleepError;
+          /** \brief wake-up latency of the agent and of the smoker workers (ns, see WAKE_*) */
+          HISTO wake[NUMWAKES];
+          /** \brief time of preparation of the first order (ns) */
+          unsigned long long firstCreated;
+          /** \brief time of the last completed cigarette (ns) */
+          unsigned long long lastDone;
+
+          /** \brief number of completed semaphore operations of each entity process (see HB_MATCHER) */
+          unsigned long long beat[NUMBEATS];
+          /** \brief semaphore each entity process is blocked on (0 if none) */
+          unsigned int blockedOn[NUMBEATS];
 
           /* semaphores ids */
-          /** \brief identification of critical region protection semaphore – val = 1 */
+          /** \brief identification of critical region protection semaphore (inventory domain) – val = 1 */
           unsigned int mutex;
+          /** \brief identification of the semaphore of each lock domain (all equal to <tt>mutex</tt> with the global
+                     lock) – val = 1 */
+          unsigned int lock[NUMDOMAINS];
           /** \brief identification of semaphore used by watchers to wait for agent - val = 0 */
           unsigned int ingredient[NUMINGREDIENTS];
           /** \brief identification of semaphore used by agent to wait for smoker to finish rolling - val = 0 */
           unsigned int waitCigarette;
-          /** \brief identification of semaphore used by smoker to wait for watchers – val = 0  */
-          unsigned int wait2Ings[NUMSMOKERS];
+          /** \brief identification of semaphore used by each smoker worker to wait for the orders pushed onto its
+                     deque – val = 0  */
+          unsigned int wait2Ings[NUMSMOKERS * MAXWORKERS];
+          /** \brief identification of semaphore used by matcher to wait for complete orders – val = 0  */
+          unsigned int arrival;
+          /** \brief identification of semaphore used by the launcher to wait for the entities to exit – val = 0  */
+          unsigned int exited;
+          /** \brief identification of semaphore counting the entities not yet ready to start – val = number of entities  */
+          unsigned int ready;
 
         } SHARED_DATA;
 
-/** \brief number of semaphores in the set */
-#define SEM_NU               ( 2 + NUMINGREDIENTS + NUMSMOKERS )
+/** \brief name of the arena region holding the shared data (one instance per factory) */
+#define SHREGION             "factories"
+
+/** \brief name of the arena region holding the state transition buffers (ENTSLOTS (nWorkers) per factory, see
+           ENT_* for the slots; allocated only when the transitions are recorded) */
+#define EVREGION             "events"
+
+/** \brief name of the arena region holding the states of the pseudo random generators (NUMENTITIES per factory) */
+#define RNGREGION            "rng"
+
+/**
+ *  \brief Definition of <em>generator slot</em> data type (state of the generator of an entity, in a cache line
+ *  of its own, since entities draw from their generators at the same time).
+ */
+typedef struct {
+    /** \brief generator state */
+    PRNG g;
+} __attribute__ ((aligned (CACHELINE))) RNG_SLOT;
+
+/** \brief number of semaphores in the set (of each factory, in multi-tenant mode), besides the start gate */
+#define SEM_NU               ( 6 + NUMINGREDIENTS + NUMSMOKERS * MAXWORKERS )
 
 #define MUTEX                  1
 #define WAITCIGARETTE          2
 #define INGREDIENT             (WAITCIGARETTE + 1)
 #define WAIT2INGS              (INGREDIENT + NUMINGREDIENTS)
+#define ARRIVAL                (WAIT2INGS + NUMSMOKERS * MAXWORKERS)
+#define EXITED                 (ARRIVAL + 1)
+#define READY                  (EXITED + 1)
+#define DISPATCH               (READY + 1)
 
 #endif /* SHAREDDATASYNC_H_ */
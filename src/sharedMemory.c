@@ -8,6 +8,7 @@
  *      \li connection to a previously created block
  *      \li destruction of a previously created block
  *      \li mapping of the block previously created on the process address space
+ *      \li read only mapping of the block previously created on the process address space
  *      \li unmapping of the block off the process address space.
  *
  *  \author António Rui Borges - October 1995
@@ -90,7 +91,31 @@ int shmemAttach (int shmid, void **pAttAdd)
      { *pAttAdd = (void *) add;
        return 0;
      }
-     else return 1;
+     else return -1;
+}
+
+/**
+ *  \brief Read only mapping of the block previously created on the process address space.
+ *
+ *  The function fails if there is no block with an identifier equal to <tt>shmid</tt>.
+ *
+ *  \param shmid block identifier
+ *  \param pAttAdd pointer to the location where the local address of the attached block is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemAttachReadOnly (int shmid, void **pAttAdd)
+{
+  void *add;                                                                                    /* temporary pointer */
+
+  add = shmat (shmid, (char *) NULL, SHM_RDONLY);
+  if (add != (void *) -1)
+     { *pAttAdd = (void *) add;
+       return 0;
+     }
+     else return -1;
 }
 
 /**
@@ -0,0 +1,571 @@
+/**
+ *  \file sockCoordinator.c (implementation file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  Synchronization based on message passing over sockets.
+ *
+ *  Coordinator of the socket transport. It owns the full state of the problem (and its logging) and drives
+ *  the agent, watcher and smoker nodes (see sockNode.c) with the protocol events of transport.h, which take
+ *  the place of the semaphore operations of the shared memory version: the agent prepares the ingredients of
+ *  an order when it gets TP_GO, the watchers reserve the ingredients they get, and the coordinator hands the
+ *  order to an idle worker of the smoker that holds the third one and notifies the agent when the cigarette
+ *  is done. The events of a node are handled in the order they were sent, and the events queued while
+ *  handling a round of frames are sent in one frame per node.
+ *
+ *  The nodes run on this host (spawned by the coordinator, over loopback) or anywhere they can reach the
+ *  coordinator (<tt>-N</tt>, each one started by hand as <tt>./node address agent|watcher id|smoker id</tt>).
+ *
+ *  Upon execution, the following parameters are accepted:
+ *    \li <tt>-l address</tt>: address the coordinator listens on, <tt>unix:path</tt> or <tt>tcp:host:port</tt>
+ *        (default <tt>unix:smokers.sock</tt>)
+ *    \li <tt>-N</tt>: the nodes are not spawned, the coordinator waits for them to join
+ *    \li <tt>-w workers</tt>: number of workers in the pool of each smoker (default 1)
+ *    \li <tt>-s seed</tt>: seed of the pseudo random generators of all nodes (default: time and pid based)
+ *    \li <tt>-n orders</tt>: number of orders to be generated by the agent (default NUMORDERS)
+ *    \li <tt>-x scale</tt>: factor applied to rolling and smoking durations (default 1, 0 disables them)
+ *    \li <tt>-b report</tt>: throughput and per stage latency are written as JSON to the report file (the
+ *        stages are timed on the clock of the coordinator, so they are valid across hosts)
+ *    \li name of the logging file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "logging.h"
+#include "sharedDataSync.h"
+#include "stats.h"
+#include "transport.h"
+
+/** \brief name of node program */
+#define   NODE                "./node"
+
+/** \brief time the nodes are given to join (ms) */
+#define   JOINTIMEOUT         10000
+
+/** \brief environment of the coordinator, inherited by the nodes */
+extern char **environ;
+
+/** \brief names of the benchmark stages, as reported */
+static const char *stageName[NUMSTAGES] = { "match", "dispatch", "roll", "total" };
+
+/** \brief logging file name */
+static char nFic[51];
+
+/** \brief full state of the problem */
+static FULL_STAT fSt;
+
+/** \brief channel of each node (indexed by ENT_* slot) */
+static TP_CHAN chan[NUMENTITIES];
+
+/** \brief flag set while the node of a slot is connected */
+static bool joined[NUMENTITIES];
+
+/** \brief number of nodes */
+static unsigned int nNodes;
+
+/** \brief flag set while a smoker worker serves an order */
+static bool busy[NUMSMOKERS*MAXWORKERS];
+
+/** \brief order waiting for an idle worker of each smoker (-1 if none) */
+static int pending[NUMSMOKERS];
+
+/** \brief worker of each smoker the search for an idle one starts at */
+static int nextWorker[NUMSMOKERS];
+
+/** \brief timestamps of the orders in flight (indexed by order id modulo ORDERSLOTS) */
+static ORDER_TIMES stamp[ORDERSLOTS];
+
+/** \brief latency of each benchmark stage (ns) */
+static HISTO latency[NUMSTAGES];
+
+/** \brief number of completed cigarettes */
+static int nDone;
+
+/** \brief time of preparation of the first order and of the last completed cigarette (ns) */
+static uint64_t firstCreated, lastDone;
+
+static void handle (unsigned int e, const TP_MSG *m);
+
+static void dispatch (int s);
+
+static void closeFactory (void);
+
+static void notify (unsigned int e, unsigned int type, uint32_t order, uint64_t arg);
+
+static void writeReport (char nRep[], const char *addr, unsigned long long seed, double timeScale);
+
+/**
+ *  \brief Main program.
+ *
+ *  Its role is to listen on the transport address, generate the nodes (unless they are started by hand),
+ *  drive the protocol until every node has left and write the benchmark report.
+ */
+int main (int argc, char *argv[])
+{
+    char addr[256] = "unix:smokers.sock";                                           /* address listened on */
+    bool spawnNodes = true;                                     /* flag set when the nodes run on this host */
+    int nWorkers = 1;                                                            /* number of workers of each smoker */
+    unsigned long long seed;                                                       /* seed of the random generators */
+    double timeScale = 1.0;                                           /* factor applied to rolling/smoking times */
+    char nRep[256] = "";                                                             /* name of benchmark report */
+    char *tinp;                                                                     /* numerical parameters test flag */
+    int opt;                                                                                   /* command line option */
+    int lfd;                                                                                   /* listening socket */
+    unsigned int e, nJoined, nOpen;
+    pid_t pid[NUMENTITIES];                                                         /* node process identifiers */
+    struct pollfd pfd[NUMENTITIES];
+    unsigned int slot[NUMENTITIES];                                                 /* node of each polled socket */
+    int failed = 0;                                                   /* number of nodes that did not succeed */
+    int status, n;
+
+    /* getting options and log file name */
+    fSt.nOrders = NUMORDERS;
+    seed = ((unsigned long long) time (NULL) << 32) ^ (unsigned long long) getpid ();
+    while ((opt = getopt (argc, argv, "l:Nw:s:n:x:b:")) != -1) {
+        switch (opt) {
+            case 'l': if (strlen (optarg) >= sizeof (addr)) {
+                          fprintf (stderr, "Address is too long!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      strcpy (addr, optarg);
+                      break;
+            case 'N': spawnNodes = false;
+                      break;
+            case 'w': nWorkers = atoi (optarg);
+                      if ((nWorkers < 1) || (nWorkers > MAXWORKERS)) {
+                          fprintf (stderr, "Number of workers must be between 1 and %d!\n", MAXWORKERS);
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 's': seed = strtoull (optarg, &tinp, 0);
+                      if (*tinp != '\0') {
+                          fprintf (stderr, "Seed must be an unsigned integer!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'n': fSt.nOrders = (int) strtol (optarg, &tinp, 0);
+                      if ((*tinp != '\0') || (fSt.nOrders < 0)) {
+                          fprintf (stderr, "Number of orders must be a non negative integer!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'x': timeScale = strtod (optarg, &tinp);
+                      if ((*tinp != '\0') || (timeScale < 0.0) || (timeScale > 4000.0)) {
+                          fprintf (stderr, "Time scale must be a real between 0 and 4000!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      break;
+            case 'b': if (strlen (optarg) >= sizeof (nRep)) {
+                          fprintf (stderr, "Report file name is too long!\n");
+                          exit (EXIT_FAILURE);
+                      }
+                      strcpy (nRep, optarg);
+                      break;
+            default:  fprintf (stderr, "Usage: %s [-l address] [-N] [-w workers] [-s seed] [-n orders] [-x scale] "
+                                       "[-b report] [logfile]\n", argv[0]);
+                      exit (EXIT_FAILURE);
+        }
+    }
+    if (optind < argc) {
+        strncpy (nFic, argv[optind], sizeof (nFic) - 1);
+        nFic[sizeof (nFic) - 1] = '\0';
+    }
+    else strcpy (nFic, "");
+
+    /* initialize problem internal status */
+    fSt.st.agentStat = PREPARING;
+    for (int w = 0; w < NUMINGREDIENTS; w++) {
+        fSt.st.watcherStat[w] = WAITING_ING;
+    }
+    for (int s = 0; s < NUMSMOKERS * nWorkers; s++) {
+        fSt.st.smokerStat[s] = WAITING_2ING;
+    }
+    for (int s = 0; s < NUMSMOKERS; s++) {
+        pending[s] = -1;
+    }
+    fSt.nIngredients = NUMINGREDIENTS;
+    fSt.nSmokers     = NUMSMOKERS;
+    fSt.nWorkers     = nWorkers;
+    nNodes = ENT_SMOKER (NUMSMOKERS * nWorkers);
+    createLog (nFic, &fSt);
+    saveState (nFic, &fSt);
+
+    /* listening on the transport address, before any node tries to join */
+    if ((lfd = tpListen (addr)) == -1) {
+        perror ("error on listening on the transport address");
+        exit (EXIT_FAILURE);
+    }
+
+    /* generation of the nodes */
+    for (e = 0; e < nNodes; e++) {
+        char id[12], *role;
+        int err;
+
+        if (!spawnNodes) {
+            pid[e] = -1;
+            continue;
+        }
+        role = (e == ENT_AGENT) ? "agent" : (e < (unsigned int) ENT_SMOKER (0)) ? "watcher" : "smoker";
+        sprintf (id, "%u", (e < (unsigned int) ENT_SMOKER (0)) ? e - ENT_WATCHER (0) : e - ENT_SMOKER (0));
+        if ((err = posix_spawn (&pid[e], NODE, NULL, NULL, (char *[]) { NODE, addr, role, id, NULL }, environ)) != 0) {
+            errno = err;
+            fprintf (stderr, "error on the generation of the %s node: ", role);
+            perror (NULL);
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    /* every node joins, announcing its slot, and gets the configuration of the run */
+    if (!spawnNodes) {
+        fprintf (stderr, "waiting for %u nodes on %s\n", nNodes, addr);
+    }
+    for (nJoined = 0; nJoined < nNodes; nJoined++) {
+        TP_CHAN ch;
+
+        if (spawnNodes) {                                           /* a node that fails to start is not waited for */
+            struct pollfd lp = { .fd = lfd, .events = POLLIN };
+
+            if (poll (&lp, 1, JOINTIMEOUT) != 1) {
+                fprintf (stderr, "only %u of %u nodes joined!\n", nJoined, nNodes);
+                exit (EXIT_FAILURE);
+            }
+        }
+        if (tpAccept (lfd, &ch) == -1) {
+            perror ("error on accepting a node");
+            exit (EXIT_FAILURE);
+        }
+        if (tpRecv (&ch) != 1) {
+            fprintf (stderr, "node did not announce itself!\n");
+            exit (EXIT_FAILURE);
+        }
+        e = ch.in[0].from;
+        if ((ch.in[0].type != TP_HELLO) || (e >= nNodes) || joined[e]) {
+            fprintf (stderr, "node with a wrong or repeated slot (%u)!\n", e);
+            exit (EXIT_FAILURE);
+        }
+        chan[e] = ch;
+        joined[e] = true;
+        notify (e, TP_WELCOME, (uint32_t) (timeScale * 1e6), seed);
+    }
+
+    /* start of operations */
+    if (fSt.nOrders > 0) {
+        notify (ENT_AGENT, TP_GO, 0, 0);
+    }
+    else closeFactory ();
+
+    /* event loop: every frame received is handled, then each node gets the events queued for it in one frame */
+    nOpen = nNodes;
+    while (nOpen > 0) {
+        for (e = 0; e < nNodes; e++) {
+            if (joined[e] && (tpFlush (&chan[e]) == -1)) {
+                perror ("error on sending to a node");
+                exit (EXIT_FAILURE);
+            }
+        }
+        for (n = 0, e = 0; e < nNodes; e++) {
+            if (joined[e]) {
+                pfd[n].fd = chan[e].fd;
+                pfd[n].events = POLLIN;
+                slot[n++] = e;
+            }
+        }
+        if (poll (pfd, (nfds_t) n, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror ("error on waiting for the nodes");
+            exit (EXIT_FAILURE);
+        }
+        for (int p = 0; p < n; p++) {
+            int nIn;
+
+            if (pfd[p].revents == 0) {
+                continue;
+            }
+            e = slot[p];
+            if ((nIn = tpRecv (&chan[e])) <= 0) {
+                if (nIn == 0) {
+                    fprintf (stderr, "node %u left before the factory closed!\n", e);
+                }
+                else perror ("error on receiving from a node");
+                exit (EXIT_FAILURE);
+            }
+            for (int i = 0; (i < nIn) && joined[e]; i++) {
+                handle (e, &chan[e].in[i]);
+            }
+            if (!joined[e]) {
+                nOpen -= 1;
+            }
+        }
+    }
+    tpUnlisten (lfd, addr);
+
+    /* waiting for the termination of the nodes */
+    for (e = 0; e < nNodes; e++) {
+        if (pid[e] < 0) {
+            continue;
+        }
+        if (waitpid (pid[e], &status, 0) == -1) {
+            perror ("error on waiting for a node");
+            exit (EXIT_FAILURE);
+        }
+        if (!WIFEXITED (status) || (WEXITSTATUS (status) != EXIT_SUCCESS)) {
+            failed += 1;
+        }
+    }
+
+    if (nRep[0] != '\0') {
+        writeReport (nRep, addr, seed, timeScale);
+    }
+    if (failed > 0) {
+        fprintf (stderr, "%d node(s) did not terminate successfully!\n", failed);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ *  \brief Handling of a protocol event.
+ *
+ *  The state is updated (and saved) as the entity that sent the event would do in the shared memory version,
+ *  and the resulting events are queued.
+ *
+ *  \param e slot of the node that sent the event
+ *  \param m pointer to the event
+ */
+static void handle (unsigned int e, const TP_MSG *m)
+{
+    ORDER_TIMES *t = &stamp[m->order % ORDERSLOTS];
+    unsigned int ing, ing2;
+    int w, s, nReserved, smoker = -1;
+
+    switch (m->type) {
+        case TP_PREPARED:                                                              /* agent -> coordinator */
+            ing = (unsigned int) (m->arg & 0xff);
+            ing2 = (unsigned int) ((m->arg >> 8) & 0xff);
+            if ((e != ENT_AGENT) || (ing >= NUMINGREDIENTS) || (ing2 >= NUMINGREDIENTS) || (ing == ing2)) {
+                break;
+            }
+            fSt.st.agentStat = PREPARING;
+            fSt.ingredients[ing] += 1;
+            fSt.ingredients[ing2] += 1;
+            t->created = nowNs ();
+            if (m->order == 0) {
+                firstCreated = t->created;
+            }
+            saveState (nFic, &fSt);
+            fSt.st.agentStat = WAITING_CIG;
+            saveState (nFic, &fSt);
+            notify (ENT_WATCHER (ing), TP_INGREDIENT, m->order, 0);
+            notify (ENT_WATCHER (ing2), TP_INGREDIENT, m->order, 0);
+            return;
+
+        case TP_RESERVE:                                                             /* watcher -> coordinator */
+            if ((e < ENT_WATCHER (0)) || (e >= ENT_SMOKER (0))) {
+                break;
+            }
+            w = (int) (e - ENT_WATCHER (0));
+            fSt.st.watcherStat[w] = UPDATING;
+            fSt.reserved[w] += 1;
+            for (nReserved = 0, s = 0; s < fSt.nIngredients; s++) {
+                if (fSt.reserved[s] > 0) nReserved += 1;
+                else smoker = s;
+            }
+            saveState (nFic, &fSt);
+            if (nReserved == 2) {                              /* the smoker holding the third ingredient may roll */
+                fSt.st.watcherStat[w] = INFORMING;
+                for (s = 0; s < fSt.nIngredients; s++) {
+                    fSt.reserved[s] = 0;
+                }
+                if (pending[smoker] >= 0) {
+                    fprintf (stderr, "order overflow of smoker %d!\n", smoker);
+                    exit (EXIT_FAILURE);
+                }
+                pending[smoker] = (int) m->order;
+                t->matched = nowNs ();
+                saveState (nFic, &fSt);
+                dispatch (smoker);
+            }
+            fSt.st.watcherStat[w] = WAITING_ING;
+            saveState (nFic, &fSt);
+            return;
+
+        case TP_ROLLING:                                                              /* smoker -> coordinator */
+            if (e < ENT_SMOKER (0)) {
+                break;
+            }
+            fSt.st.smokerStat[e - ENT_SMOKER (0)] = ROLLING;
+            for (int i = 0; i < NUMINGREDIENTS; i++) {
+                fSt.ingredients[i] = 0;
+            }
+            t->rolling = nowNs ();
+            saveState (nFic, &fSt);
+            return;
+
+        case TP_DONE:                                                                 /* smoker -> coordinator */
+            if (e < ENT_SMOKER (0)) {
+                break;
+            }
+            t->done = lastDone = nowNs ();
+            histoAdd (&latency[STAGE_MATCH], t->matched - t->created);
+            histoAdd (&latency[STAGE_DISPATCH], t->rolling - t->matched);
+            histoAdd (&latency[STAGE_ROLL], t->done - t->rolling);
+            histoAdd (&latency[STAGE_TOTAL], t->done - t->created);
+            fSt.st.smokerStat[e - ENT_SMOKER (0)] = SMOKING;
+            fSt.nCigarettes[e - ENT_SMOKER (0)] += 1;
+            saveState (nFic, &fSt);
+            if (++nDone < fSt.nOrders) {                           /* the agent waits for the cigarette */
+                notify (ENT_AGENT, TP_GO, (uint32_t) nDone, 0);
+            }
+            else closeFactory ();
+            return;
+
+        case TP_WAITING:                                                              /* smoker -> coordinator */
+            if (e < ENT_SMOKER (0)) {
+                break;
+            }
+            fSt.st.smokerStat[e - ENT_SMOKER (0)] = WAITING_2ING;
+            busy[e - ENT_SMOKER (0)] = false;
+            saveState (nFic, &fSt);
+            dispatch ((int) (e - ENT_SMOKER (0)) / fSt.nWorkers);
+            return;
+
+        case TP_BYE:                                                                    /* node -> coordinator */
+            if (!fSt.closing) {
+                break;
+            }
+            if (e >= ENT_SMOKER (0)) {
+                fSt.st.smokerStat[e - ENT_SMOKER (0)] = CLOSING_S;
+                saveState (nFic, &fSt);
+            }
+            else if (e != ENT_AGENT) {
+                fSt.st.watcherStat[e - ENT_WATCHER (0)] = CLOSING_W;
+                saveState (nFic, &fSt);
+            }
+            tpClose (&chan[e]);
+            joined[e] = false;
+            return;
+    }
+    fprintf (stderr, "unexpected event %u from node %u!\n", m->type, e);
+    exit (EXIT_FAILURE);
+}
+
+/**
+ *  \brief Hand-off of the pending order of a smoker.
+ *
+ *  The order is handed to an idle worker of the smoker, if any (the search starts after the worker that got
+ *  the previous order, so the orders are spread over the pool); otherwise it waits for a worker to finish.
+ *
+ *  \param s smoker
+ */
+static void dispatch (int s)
+{
+    int w, id;
+
+    if (pending[s] < 0) {
+        return;
+    }
+    for (int k = 0; k < fSt.nWorkers; k++) {
+        w = (nextWorker[s] + k) % fSt.nWorkers;
+        id = s * fSt.nWorkers + w;
+        if (!busy[id]) {
+            busy[id] = true;
+            nextWorker[s] = w + 1;
+            notify (ENT_SMOKER (id), TP_ORDER, (uint32_t) pending[s], 0);
+            pending[s] = -1;
+            return;
+        }
+    }
+}
+
+/**
+ *  \brief Closing of the factory.
+ *
+ *  The agent state is updated and every node is told that the factory is closing.
+ */
+static void closeFactory (void)
+{
+    fSt.st.agentStat = CLOSING_A;
+    fSt.closing = true;
+    saveState (nFic, &fSt);
+    for (unsigned int e = 0; e < nNodes; e++) {
+        notify (e, TP_CLOSE, (uint32_t) nDone, 0);
+    }
+}
+
+/**
+ *  \brief Queueing of an event for a node.
+ *
+ *  The coordinator exits on failure.
+ *
+ *  \param e slot of the node
+ *  \param type type of the event
+ *  \param order id of the order
+ *  \param arg argument of the event
+ */
+static void notify (unsigned int e, unsigned int type, uint32_t order, uint64_t arg)
+{
+    if (tpQueue (&chan[e], type, ENT_AGENT, order, arg) == -1) {
+        perror ("error on sending to a node");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief Writing the benchmark report.
+ *
+ *  A single JSON object holds the configuration of the run, the throughput (orders per second, from the
+ *  preparation of the first order to the completion of the last cigarette), the latency histogram of each
+ *  benchmark stage, in nanoseconds, and the number of frames and events sent by the coordinator.
+ *
+ *  \param nRep name of the report file
+ *  \param addr transport address
+ *  \param seed seed of the random generators
+ *  \param timeScale factor applied to rolling/smoking times
+ */
+static void writeReport (char nRep[], const char *addr, unsigned long long seed, double timeScale)
+{
+    FILE *fic;                                                                                      /* file descriptor */
+    double elapsed;                                                                          /* elapsed time (s) */
+    unsigned long long frames = 0, events = 0;
+
+    if ((fic = fopen (nRep, "w")) == NULL) {
+        perror ("error on opening the report file");
+        exit (EXIT_FAILURE);
+    }
+    for (unsigned int e = 0; e < nNodes; e++) {
+        frames += chan[e].frames;
+        events += chan[e].events;
+    }
+    elapsed = (nDone > 0) ? (lastDone - firstCreated) / 1e9 : 0.0;
+    fprintf (fic, "{\"transport\":\"%.*s\",\"orders\":%d,\"smokers\":%d,\"workers\":%d,\"timeScale\":%g,"
+                  "\"seed\":%llu,\"elapsed_s\":%.6f,\"orders_per_s\":%.1f,\"frames\":%llu,\"events\":%llu,"
+                  "\"latency_ns\":{",
+             (int) strcspn (addr, ":"), addr, fSt.nOrders, fSt.nSmokers, fSt.nWorkers, timeScale, seed, elapsed,
+             (elapsed > 0.0) ? nDone / elapsed : 0.0, frames, events);
+    for (int st = 0; st < NUMSTAGES; st++) {
+        fprintf (fic, "%s\"%s\":", (st > 0) ? "," : "", stageName[st]);
+        histoPrintJson (fic, &latency[st]);
+    }
+    fprintf (fic, "}}\n");
+
+    if (fclose (fic) == EOF) {
+        perror ("error on closing the report file");
+        exit (EXIT_FAILURE);
+    }
+}
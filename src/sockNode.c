@@ -0,0 +1,208 @@
+/**
+ *  \file sockNode.c (implementation file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  Synchronization based on message passing over sockets.
+ *
+ *  Entity node of the socket transport: the agent, a watcher or a smoker worker, which may run on any host
+ *  that reaches the coordinator (see sockCoordinator.c). The node joins the factory, gets the seed and the time
+ *  scale of the run and then answers the protocol events of the coordinator, which owns the state:
+ *    \li the agent prepares the ingredients of an order (with the same random generator stream as in the
+ *        shared memory version)
+ *    \li a watcher reserves the ingredient it gets
+ *    \li a smoker worker rolls the cigarette of the order it gets and smokes it, taking the same durations as in
+ *        the shared memory version.
+ *
+ *  The events a node sends back without sleeping in between go in a single frame.
+ *
+ *  Upon execution, the following parameters are accepted:
+ *    \li address of the coordinator, <tt>unix:path</tt> or <tt>tcp:host:port</tt>
+ *    \li role, <tt>agent</tt>, <tt>watcher</tt> or <tt>smoker</tt>
+ *    \li id of the watcher or of the smoker worker.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "sharedDataSync.h"
+#include "prng.h"
+#include "timing.h"
+#include "transport.h"
+
+/** \brief time given to the coordinator to start listening (ms) */
+#define   CONNECTTIMEOUT      10000
+
+/** \brief channel to the coordinator */
+static TP_CHAN ch;
+
+/** \brief slot of the node (ENT_*) */
+static unsigned int self;
+
+/** \brief pseudo random generator of the node */
+static PRNG rng;
+
+/** \brief factor applied to rolling and smoking durations */
+static double timeScale;
+
+static void queue (unsigned int type, uint32_t order, uint64_t arg);
+
+static void flush (void);
+
+static void serveOrder (uint32_t order);
+
+/**
+ *  \brief Main program.
+ *
+ *  Its role is to join the factory and to answer the events of the coordinator until the factory closes.
+ */
+int main (int argc, char *argv[])
+{
+    char *tinp;                                                                     /* numerical parameters test flag */
+    long id = 0;
+    bool welcomed = false, closing = false;
+    int n;
+
+    /* validation of the command line parameters */
+    if ((argc < 3) || ((strcmp (argv[2], "agent") != 0) && (argc != 4))) {
+        fprintf (stderr, "Usage: %s address agent|watcher id|smoker id\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc == 4) {
+        id = strtol (argv[3], &tinp, 0);
+        if ((*tinp != '\0') || (id < 0)) {
+            fprintf (stderr, "Node id must be a non negative integer!\n");
+            return EXIT_FAILURE;
+        }
+    }
+    if (strcmp (argv[2], "agent") == 0) self = ENT_AGENT;
+    else if ((strcmp (argv[2], "watcher") == 0) && (id < NUMINGREDIENTS)) self = ENT_WATCHER (id);
+    else if ((strcmp (argv[2], "smoker") == 0) && (id < NUMSMOKERS * MAXWORKERS)) self = ENT_SMOKER (id);
+    else {
+        fprintf (stderr, "Node role must be agent, watcher (id below %d) or smoker (id below %d)!\n",
+                 NUMINGREDIENTS, NUMSMOKERS * MAXWORKERS);
+        return EXIT_FAILURE;
+    }
+
+    /* joining the factory */
+    if (tpConnect (argv[1], CONNECTTIMEOUT, &ch) == -1) {
+        perror ("error on connecting to the coordinator");
+        return EXIT_FAILURE;
+    }
+    queue (TP_HELLO, 0, 0);
+    flush ();
+    if (tmInit (0) == -1) {
+        perror ("error on setting the timer slack");
+        return EXIT_FAILURE;
+    }
+
+    /* answering the events of the coordinator */
+    while (!closing) {
+        if ((n = tpRecv (&ch)) <= 0) {
+            if (n == 0) {
+                fprintf (stderr, "coordinator left before the factory closed!\n");
+            }
+            else perror ("error on receiving from the coordinator");
+            return EXIT_FAILURE;
+        }
+        for (int i = 0; i < n; i++) {
+            TP_MSG *m = &ch.in[i];
+            unsigned int ing, ing2;
+
+            if ((m->type == TP_WELCOME) && !welcomed) {
+                timeScale = m->order / 1e6;
+                /* random generator streams: 0 belongs to the agent, 1 + worker index to the smoker workers */
+                prngSeed (&rng, m->arg, (self >= ENT_SMOKER (0)) ? 1 + self - ENT_SMOKER (0) : 0);
+                welcomed = true;
+            }
+            else if (!welcomed) {
+                fprintf (stderr, "coordinator did not welcome the node!\n");
+                return EXIT_FAILURE;
+            }
+            else if (m->type == TP_CLOSE) {
+                queue (TP_BYE, m->order, 0);
+                closing = true;
+            }
+            else if ((m->type == TP_GO) && (self == ENT_AGENT)) {
+                prngPair (&rng, NUMINGREDIENTS, &ing, &ing2);             /* pack of 2 different ingredients */
+                queue (TP_PREPARED, m->order, ing | (ing2 << 8));
+            }
+            else if ((m->type == TP_INGREDIENT) && (self > ENT_AGENT) && (self < ENT_SMOKER (0))) {
+                queue (TP_RESERVE, m->order, 0);
+            }
+            else if ((m->type == TP_ORDER) && (self >= ENT_SMOKER (0))) {
+                serveOrder (m->order);
+            }
+            else {
+                fprintf (stderr, "unexpected event %u from the coordinator!\n", m->type);
+                return EXIT_FAILURE;
+            }
+        }
+        flush ();
+    }
+    tpClose (&ch);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ *  \brief Smoker worker serves an order.
+ *
+ *  The worker rolls the cigarette and notifies the coordinator when it is done (so the agent may go on), then
+ *  smokes it and tells the coordinator it waits again. The events are sent before each sleep.
+ *
+ *  \param order id of the order
+ */
+static void serveOrder (uint32_t order)
+{
+    double rollingTime = (100.0 + prngNormal (&rng) * 30.0) * timeScale;
+    double smokingTime;
+
+    queue (TP_ROLLING, order, 0);
+    if (rollingTime > 0) {
+        flush ();
+        tmSleep (rollingTime);
+    }
+    queue (TP_DONE, order, 0);
+    smokingTime = (100.0 + prngNormal (&rng) * 30.0) * timeScale;
+    if (smokingTime > 0) {
+        flush ();
+        tmSleep (smokingTime);
+    }
+    queue (TP_WAITING, order, 0);
+}
+
+/**
+ *  \brief Queueing of an event for the coordinator.
+ *
+ *  The node exits on failure.
+ *
+ *  \param type type of the event
+ *  \param order id of the order
+ *  \param arg argument of the event
+ */
+static void queue (unsigned int type, uint32_t order, uint64_t arg)
+{
+    if (tpQueue (&ch, type, self, order, arg) == -1) {
+        perror ("error on sending to the coordinator");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief Sending of the queued events to the coordinator.
+ *
+ *  The node exits on failure.
+ */
+static void flush (void)
+{
+    if (tpFlush (&ch) == -1) {
+        perror ("error on sending to the coordinator");
+        exit (EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,181 @@
+/**
+ *  \file stats.c (implementation file)
+ *
+ *  \brief Time measurement and latency histograms.
+ *
+ *  Histograms are log-linear: values below 2^(HISTOSUBBITS+1) have their own bucket and every power of
+ *  two above is split into 2^HISTOSUBBITS buckets, so percentiles have a relative error below 2^-HISTOSUBBITS.
+ *  They hold no pointers and can be placed in shared memory (a zero filled histogram is empty).
+ *
+ *  Defined operations:
+ *     \li reading of the monotonic clock
+ *     \li adding a value to a histogram and merging histograms
+ *     \li computing the mean and percentiles of a histogram
+ *     \li printing a histogram as a JSON object
+ *     \li printing a string as a JSON string.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "stats.h"
+
+/** \brief number of sub-buckets of each power of two */
+#define  SUB            (1u << HISTOSUBBITS)
+
+/* internal functions */
+
+static unsigned int bucketOf (uint64_t v)
+{
+    unsigned int shift;
+
+    if (v < 2 * SUB)
+       return (unsigned int) v;
+    shift = (63 - __builtin_clzll (v)) - HISTOSUBBITS;
+    return (shift + 1) * SUB + (unsigned int) (v >> shift) - SUB;
+}
+
+static uint64_t bucketMid (unsigned int b)
+{
+    unsigned int shift;
+
+    if (b < 2 * SUB)
+       return b;
+    shift = b / SUB - 1;
+    return ((uint64_t) (SUB + b % SUB) << shift) + (((uint64_t) 1 << shift) >> 1);
+}
+
+/* external functions */
+
+/**
+ *  \brief Reading of the monotonic clock.
+ *
+ *  \return time in nanoseconds
+ */
+uint64_t nowNs (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ *  \brief Adding a value to a histogram.
+ *
+ *  \param h pointer to the histogram
+ *  \param v value
+ */
+void histoAdd (HISTO *h, uint64_t v)
+{
+    if ((h->count == 0) || (v < h->min))
+       h->min = v;
+    if (v > h->max)
+       h->max = v;
+    h->count += 1;
+    h->sum += v;
+    h->bucket[bucketOf (v)] += 1;
+}
+
+/**
+ *  \brief Merging a histogram into another.
+ *
+ *  \param h pointer to the histogram that is updated
+ *  \param o pointer to the histogram that is added
+ */
+void histoMerge (HISTO *h, const HISTO *o)
+{
+    unsigned int b;
+
+    if (o->count == 0)
+       return;
+    if ((h->count == 0) || (o->min < h->min))
+       h->min = o->min;
+    if (o->max > h->max)
+       h->max = o->max;
+    h->count += o->count;
+    h->sum += o->sum;
+    for (b = 0; b < HISTOBUCKETS; b++)
+      h->bucket[b] += o->bucket[b];
+}
+
+/**
+ *  \brief Computing the mean of a histogram.
+ *
+ *  \param h pointer to the histogram
+ *
+ *  \return mean of the values (0 if empty)
+ */
+double histoMean (const HISTO *h)
+{
+    return (h->count == 0) ? 0.0 : (double) h->sum / (double) h->count;
+}
+
+/**
+ *  \brief Computing a percentile of a histogram.
+ *
+ *  \param h pointer to the histogram
+ *  \param q quantile, in [0, 1]
+ *
+ *  \return value of the quantile (midpoint of its bucket, 0 if empty)
+ */
+uint64_t histoPercentile (const HISTO *h, double q)
+{
+    uint64_t rank, seen = 0, v;
+    unsigned int b;
+
+    if (h->count == 0)
+       return 0;
+    rank = (uint64_t) (q * (double) (h->count - 1)) + 1;
+    for (b = 0; b < HISTOBUCKETS; b++) {
+        seen += h->bucket[b];
+        if (seen >= rank)
+           break;
+    }
+    v = bucketMid (b);
+    if (v < h->min)
+       return h->min;
+    if (v > h->max)
+       return h->max;
+    return v;
+}
+
+/**
+ *  \brief Printing a histogram as a JSON object.
+ *
+ *  The object holds count, mean, min, p50, p90, p99, p999 and max.
+ *
+ *  \param fic output stream
+ *  \param h pointer to the histogram
+ */
+void histoPrintJson (FILE *fic, const HISTO *h)
+{
+    fprintf (fic, "{\"count\":%llu,\"mean\":%.1f,\"min\":%llu,\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,"
+                  "\"p999\":%llu,\"max\":%llu}",
+             (unsigned long long) h->count, histoMean (h), (unsigned long long) (h->count ? h->min : 0),
+             (unsigned long long) histoPercentile (h, 0.5), (unsigned long long) histoPercentile (h, 0.9),
+             (unsigned long long) histoPercentile (h, 0.99), (unsigned long long) histoPercentile (h, 0.999),
+             (unsigned long long) h->max);
+}
+
+/**
+ *  \brief Printing a string as a JSON string.
+ *
+ *  Quotes, backslashes and control characters are escaped.
+ *
+ *  \param fic output stream
+ *  \param s null terminated string
+ */
+void jsonPrintString (FILE *fic, const char *s)
+{
+    fputc ('"', fic);
+    for (; *s != '\0'; s++) {
+        if ((*s == '"') || (*s == '\\'))
+           fprintf (fic, "\\%c", *s);
+        else if ((unsigned char) *s < 0x20)
+                fprintf (fic, "\\u%04x", (unsigned char) *s);
+             else fputc (*s, fic);
+    }
+    fputc ('"', fic);
+}
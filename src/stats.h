@@ -0,0 +1,107 @@
+/**
+ *  \file stats.h (interface file)
+ *
+ *  \brief Time measurement and latency histograms.
+ *
+ *  Histograms are log-linear: values below 2^(HISTOSUBBITS+1) have their own bucket and every power of
+ *  two above is split into 2^HISTOSUBBITS buckets, so percentiles have a relative error below 2^-HISTOSUBBITS.
+ *  They hold no pointers and can be placed in shared memory (a zero filled histogram is empty).
+ *
+ *  Defined operations:
+ *     \li reading of the monotonic clock
+ *     \li adding a value to a histogram and merging histograms
+ *     \li computing the mean and percentiles of a histogram
+ *     \li printing a histogram as a JSON object
+ *     \li printing a string as a JSON string.
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+/** \brief number of bits of the sub-buckets of each power of two */
+#define  HISTOSUBBITS     5
+/** \brief number of buckets of a histogram */
+#define  HISTOBUCKETS     ((65 - HISTOSUBBITS) << HISTOSUBBITS)
+
+/**
+ *  \brief Definition of <em>histogram</em> data type.
+ */
+typedef struct {
+    /** \brief number of values */
+    uint64_t count;
+    /** \brief sum of values */
+    uint64_t sum;
+    /** \brief smallest value */
+    uint64_t min;
+    /** \brief largest value */
+    uint64_t max;
+    /** \brief number of values in each bucket */
+    uint64_t bucket[HISTOBUCKETS];
+} HISTO;
+
+/**
+ *  \brief Reading of the monotonic clock.
+ *
+ *  \return time in nanoseconds
+ */
+extern uint64_t nowNs (void);
+
+/**
+ *  \brief Adding a value to a histogram.
+ *
+ *  \param h pointer to the histogram
+ *  \param v value
+ */
+extern void histoAdd (HISTO *h, uint64_t v);
+
+/**
+ *  \brief Merging a histogram into another.
+ *
+ *  \param h pointer to the histogram that is updated
+ *  \param o pointer to the histogram that is added
+ */
+extern void histoMerge (HISTO *h, const HISTO *o);
+
+/**
+ *  \brief Computing the mean of a histogram.
+ *
+ *  \param h pointer to the histogram
+ *
+ *  \return mean of the values (0 if empty)
+ */
+extern double histoMean (const HISTO *h);
+
+/**
+ *  \brief Computing a percentile of a histogram.
+ *
+ *  \param h pointer to the histogram
+ *  \param q quantile, in [0, 1]
+ *
+ *  \return value of the quantile (midpoint of its bucket, 0 if empty)
+ */
+extern uint64_t histoPercentile (const HISTO *h, double q);
+
+/**
+ *  \brief Printing a histogram as a JSON object.
+ *
+ *  The object holds count, mean, min, p50, p90, p99, p999 and max.
+ *
+ *  \param fic output stream
+ *  \param h pointer to the histogram
+ */
+extern void histoPrintJson (FILE *fic, const HISTO *h);
+
+/**
+ *  \brief Printing a string as a JSON string.
+ *
+ *  Quotes, backslashes and control characters are escaped.
+ *
+ *  \param fic output stream
+ *  \param s null terminated string
+ */
+extern void jsonPrintString (FILE *fic, const char *s);
+
+#endif /* STATS_H_ */
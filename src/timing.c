@@ -0,0 +1,72 @@
+/**
+ *  \file timing.c (implementation file)
+ *
+ *  \brief Precise sleeps for the modelled durations.
+ *
+ *  A sleep runs to an absolute deadline of the monotonic clock (<tt>clock_nanosleep</tt>), so neither the
+ *  truncation of the duration nor the time spent before going to sleep adds to it, with the timer slack of
+ *  the process reduced to its minimum. Optionally, the last microseconds before the deadline are spent
+ *  busy waiting, which removes most of the wake up latency at the cost of processor time.
+ *  The achieved error (time past the deadline) of every sleep is returned, to be accounted for.
+ *
+ *  Defined operations:
+ *     \li initialization of the timing of the calling process
+ *     \li sleep.
+ */
+
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/prctl.h>
+
+#include "timing.h"
+#include "stats.h"
+
+/** \brief length of the busy wait before each deadline (ns) */
+static uint64_t spin = 0;
+
+/**
+ *  \brief Initialization of the timing of the calling process.
+ *
+ *  The timer slack of the process is set to its minimum (1 ns).
+ *
+ *  \param spinNs length of the busy wait before each deadline (ns), 0 disables it
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int tmInit (unsigned int spinNs)
+{
+    spin = spinNs;
+    return prctl (PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+}
+
+/**
+ *  \brief Sleep.
+ *
+ *  \param us duration (in microseconds), nothing is done if it is not positive
+ *
+ *  \return time past the deadline when the process resumed (ns)
+ */
+uint64_t tmSleep (double us)
+{
+    uint64_t deadline, wake, t;                                                          /* absolute times (ns) */
+    struct timespec ts;
+
+    if (!(us > 0.0)) {
+        return 0;
+    }
+    deadline = nowNs () + (uint64_t) (us * 1000.0 + 0.5);
+    wake = deadline - spin;
+    if ((spin == 0) || (wake > nowNs ())) {
+        ts.tv_sec = (time_t) (wake / 1000000000ull);
+        ts.tv_nsec = (long) (wake % 1000000000ull);
+        while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+            ;                                                         /* the deadline is absolute, so just resume */
+        }
+    }
+    while ((t = nowNs ()) < deadline) {
+        ;                                                                          /* busy wait of the last part */
+    }
+    return t - deadline;
+}
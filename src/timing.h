@@ -0,0 +1,43 @@
+/**
+ *  \file timing.h (interface file)
+ *
+ *  \brief Precise sleeps for the modelled durations.
+ *
+ *  A sleep runs to an absolute deadline of the monotonic clock (<tt>clock_nanosleep</tt>), so neither the
+ *  truncation of the duration nor the time spent before going to sleep adds to it, with the timer slack of
+ *  the process reduced to its minimum. Optionally, the last microseconds before the deadline are spent
+ *  busy waiting, which removes most of the wake up latency at the cost of processor time.
+ *  The achieved error (time past the deadline) of every sleep is returned, to be accounted for.
+ *
+ *  Defined operations:
+ *     \li initialization of the timing of the calling process
+ *     \li sleep.
+ */
+
+#ifndef TIMING_H_
+#define TIMING_H_
+
+#include <stdint.h>
+
+/**
+ *  \brief Initialization of the timing of the calling process.
+ *
+ *  The timer slack of the process is set to its minimum (1 ns).
+ *
+ *  \param spinNs length of the busy wait before each deadline (ns), 0 disables it
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int tmInit (unsigned int spinNs);
+
+/**
+ *  \brief Sleep.
+ *
+ *  \param us duration (in microseconds), nothing is done if it is not positive
+ *
+ *  \return time past the deadline when the process resumed (ns)
+ */
+extern uint64_t tmSleep (double us);
+
+#endif /* TIMING_H_ */
@@ -0,0 +1,212 @@
+/**
+ *  \file trace.c (implementation file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  \brief Binary order traces, mapped into memory.
+ *
+ *  A trace holds a header followed by one fixed size record per order. Each record carries the pack of
+ *  2 ingredients of the order and, optionally, the rolling and smoking durations of the cigarette.
+ *  Records are accessed in place, without any parsing.
+ *
+ *  Defined operations:
+ *     \li creation of a trace file with room for a given number of orders
+ *     \li mapping of an existing trace file (read only)
+ *     \li validation of the contents of a trace
+ *     \li access to the ingredients and durations of an order
+ *     \li unmapping of a trace.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "trace.h"
+
+/* internal functions */
+
+static size_t recordSize (uint16_t flags)
+{
+    return (flags & TRACEDURATIONS) ? sizeof (TRACE_RECORD) : 2;
+}
+
+static void setup (TRACE *t, void *base, size_t size)
+{
+    t->base = base;
+    t->size = size;
+    t->hdr = (TRACE_HEADER *) base;
+    t->rec = (unsigned char *) base + sizeof (TRACE_HEADER);
+    t->stride = recordSize (t->hdr->flags);
+}
+
+/* external functions */
+
+/**
+ *  \brief Creation of a trace file with room for a given number of orders.
+ *
+ *  The file is mapped read-write and its header is filled; records are to be written in place.
+ *
+ *  \param name name of the trace file
+ *  \param nOrders number of orders
+ *  \param flags trace flags
+ *  \param t pointer to the mapped trace
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int traceCreate (const char *name, uint64_t nOrders, uint16_t flags, TRACE *t)
+{
+    size_t size = sizeof (TRACE_HEADER) + nOrders * recordSize (flags);
+    void *base;
+    int fd;
+
+    if ((fd = open (name, O_RDWR | O_CREAT | O_TRUNC, 0644)) == -1)
+       return -1;
+    if ((ftruncate (fd, (off_t) size) == -1) ||
+        ((base = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)) {
+       int err = errno;
+       close (fd);
+       errno = err;
+       return -1;
+    }
+    close (fd);
+
+    ((TRACE_HEADER *) base)->magic = TRACEMAGIC;
+    ((TRACE_HEADER *) base)->version = TRACEVERSION;
+    ((TRACE_HEADER *) base)->flags = flags;
+    ((TRACE_HEADER *) base)->nOrders = nOrders;
+    setup (t, base, size);
+
+    return 0;
+}
+
+/**
+ *  \brief Mapping of an existing trace file (read only).
+ *
+ *  \param name name of the trace file
+ *  \param t pointer to the mapped trace
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int traceOpen (const char *name, TRACE *t)
+{
+    struct stat st;
+    TRACE_HEADER *hdr;
+    void *base;
+    int fd;
+
+    if ((fd = open (name, O_RDONLY)) == -1)
+       return -1;
+    if (fstat (fd, &st) == -1) {
+       int err = errno;
+       close (fd);
+       errno = err;
+       return -1;
+    }
+    if ((size_t) st.st_size < sizeof (TRACE_HEADER)) {
+       close (fd);
+       errno = EINVAL;
+       return -1;
+    }
+    if ((base = mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+       int err = errno;
+       close (fd);
+       errno = err;
+       return -1;
+    }
+    close (fd);
+
+    hdr = (TRACE_HEADER *) base;
+    if ((hdr->magic != TRACEMAGIC) || (hdr->version != TRACEVERSION) ||
+        ((size_t) st.st_size < sizeof (TRACE_HEADER) + hdr->nOrders * recordSize (hdr->flags))) {
+       munmap (base, (size_t) st.st_size);
+       errno = EINVAL;
+       return -1;
+    }
+    setup (t, base, (size_t) st.st_size);
+    madvise (base, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+    return 0;
+}
+
+/**
+ *  \brief Validation of the contents of a trace.
+ *
+ *  Every order must have 2 different ingredients below <tt>nIngredients</tt>.
+ *
+ *  \param t pointer to the mapped trace
+ *  \param nIngredients number of ingredients
+ *
+ *  \return index of the first invalid order; number of orders, if the trace is valid
+ */
+uint64_t traceValidate (const TRACE *t, unsigned int nIngredients)
+{
+    unsigned int a, b;
+    uint64_t i;
+
+    for (i = 0; i < t->hdr->nOrders; i++) {
+        traceOrder (t, i, &a, &b);
+        if ((a >= nIngredients) || (b >= nIngredients) || (a == b))
+           break;
+    }
+
+    return i;
+}
+
+/**
+ *  \brief Access to the ingredients of an order.
+ *
+ *  \param t pointer to the mapped trace
+ *  \param order id of the order
+ *  \param pA pointer to the location where the first ingredient is stored
+ *  \param pB pointer to the location where the second ingredient is stored
+ */
+void traceOrder (const TRACE *t, uint64_t order, unsigned int *pA, unsigned int *pB)
+{
+    const uint8_t *ing = t->rec + order * t->stride;
+
+    *pA = ing[0];
+    *pB = ing[1];
+}
+
+/**
+ *  \brief Access to the rolling and smoking durations of an order.
+ *
+ *  \param t pointer to the mapped trace
+ *  \param order id of the order
+ *  \param pRolling pointer to the location where the rolling duration (us) is stored
+ *  \param pSmoking pointer to the location where the smoking duration (us) is stored
+ *
+ *  \return true if the trace carries durations; false otherwise
+ */
+bool traceDurations (const TRACE *t, uint64_t order, double *pRolling, double *pSmoking)
+{
+    const TRACE_RECORD *r;
+
+    if (!(t->hdr->flags & TRACEDURATIONS))
+       return false;
+    r = (const TRACE_RECORD *) (t->rec + order * t->stride);
+    *pRolling = r->rolling;
+    *pSmoking = r->smoking;
+
+    return true;
+}
+
+/**
+ *  \brief Unmapping of a trace.
+ *
+ *  \param t pointer to the mapped trace
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int traceClose (TRACE *t)
+{
+    return munmap (t->base, t->size);
+}
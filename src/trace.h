@@ -0,0 +1,148 @@
+/**
+ *  \file trace.h (interface file)
+ *
+ *  \brief Problem name: Smokers
+ *
+ *  \brief Binary order traces, mapped into memory.
+ *
+ *  A trace holds a header followed by one fixed size record per order. Each record carries the pack of
+ *  2 ingredients of the order and, optionally, the rolling and smoking durations of the cigarette.
+ *  Records are accessed in place, without any parsing.
+ *
+ *  Defined operations:
+ *     \li creation of a trace file with room for a given number of orders
+ *     \li mapping of an existing trace file (read only)
+ *     \li validation of the contents of a trace
+ *     \li access to the ingredients and durations of an order
+ *     \li unmapping of a trace.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** \brief identification of trace files ("SMKT") */
+#define  TRACEMAGIC       0x544b4d53u
+/** \brief version of the trace format */
+#define  TRACEVERSION     1
+/** \brief flag: records carry rolling and smoking durations */
+#define  TRACEDURATIONS   0x1
+
+/**
+ *  \brief Definition of <em>trace header</em> data type.
+ */
+typedef struct {
+    /** \brief identification of trace files */
+    uint32_t magic;
+    /** \brief version of the trace format */
+    uint16_t version;
+    /** \brief trace flags */
+    uint16_t flags;
+    /** \brief number of orders */
+    uint64_t nOrders;
+} TRACE_HEADER;
+
+/**
+ *  \brief Definition of <em>order record</em> data type (with durations, when TRACEDURATIONS is set).
+ */
+typedef struct {
+    /** \brief pack of 2 different ingredients */
+    uint8_t ing[2];
+    /** \brief padding */
+    uint8_t pad[2];
+    /** \brief rolling duration (us) */
+    float rolling;
+    /** \brief smoking duration (us) */
+    float smoking;
+} TRACE_RECORD;
+
+/**
+ *  \brief Definition of <em>mapped trace</em> data type.
+ */
+typedef struct {
+    /** \brief address of the mapping */
+    void *base;
+    /** \brief size of the mapping (in bytes) */
+    size_t size;
+    /** \brief header of the trace */
+    TRACE_HEADER *hdr;
+    /** \brief first record */
+    unsigned char *rec;
+    /** \brief size of each record (in bytes) */
+    size_t stride;
+} TRACE;
+
+/**
+ *  \brief Creation of a trace file with room for a given number of orders.
+ *
+ *  The file is mapped read-write and its header is filled; records are to be written in place.
+ *
+ *  \param name name of the trace file
+ *  \param nOrders number of orders
+ *  \param flags trace flags
+ *  \param t pointer to the mapped trace
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int traceCreate (const char *name, uint64_t nOrders, uint16_t flags, TRACE *t);
+
+/**
+ *  \brief Mapping of an existing trace file (read only).
+ *
+ *  \param name name of the trace file
+ *  \param t pointer to the mapped trace
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int traceOpen (const char *name, TRACE *t);
+
+/**
+ *  \brief Validation of the contents of a trace.
+ *
+ *  Every order must have 2 different ingredients below <tt>nIngredients</tt>.
+ *
+ *  \param t pointer to the mapped trace
+ *  \param nIngredients number of ingredients
+ *
+ *  \return index of the first invalid order; number of orders, if the trace is valid
+ */
+extern uint64_t traceValidate (const TRACE *t, unsigned int nIngredients);
+
+/**
+ *  \brief Access to the ingredients of an order.
+ *
+ *  \param t pointer to the mapped trace
+ *  \param order id of the order
+ *  \param pA pointer to the location where the first ingredient is stored
+ *  \param pB pointer to the location where the second ingredient is stored
+ */
+extern void traceOrder (const TRACE *t, uint64_t order, unsigned int *pA, unsigned int *pB);
+
+/**
+ *  \brief Access to the rolling and smoking durations of an order.
+ *
+ *  \param t pointer to the mapped trace
+ *  \param order id of the order
+ *  \param pRolling pointer to the location where the rolling duration (us) is stored
+ *  \param pSmoking pointer to the location where the smoking duration (us) is stored
+ *
+ *  \return true if the trace carries durations; false otherwise
+ */
+extern bool traceDurations (const TRACE *t, uint64_t order, double *pRolling, double *pSmoking);
+
+/**
+ *  \brief Unmapping of a trace.
+ *
+ *  \param t pointer to the mapped trace
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int traceClose (TRACE *t);
+
+#endif /* TRACE_H_ */
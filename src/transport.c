@@ -0,0 +1,405 @@
+/**
+ *  \file transport.c (implementation file)
+ *
+ *  \brief Socket transport of the protocol events between the coordinator and the entity nodes.
+ *
+ *  A channel is a stream connection (Unix-domain or TCP) that carries frames: a 32 bit length prefix followed by
+ *  a batch of fixed size events. Events are queued straight into the batch of the channel, in network byte
+ *  order, and a frame is sent with a single gather write of the prefix and the batch; a received frame is
+ *  read straight into the receive batch and its events are converted in place. No event is copied into an
+ *  intermediate buffer on either side.
+ *
+ *  Addresses are given as <tt>unix:path</tt> or <tt>tcp:host:port</tt> (an empty host listens on every interface).
+ *
+ *  Defined operations:
+ *     \li listening on an address
+ *     \li acceptance of a connection
+ *     \li connection to an address
+ *     \li queueing of an event
+ *     \li sending of the queued events in a frame
+ *     \li reception of a frame
+ *     \li closing of a channel and of a listening socket.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <endian.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "transport.h"
+#include "stats.h"
+
+/* internal functions */
+
+/**
+ *  \brief Resolution of an address.
+ *
+ *  \param addr address
+ *  \param passive flag set when the address is listened on
+ *  \param sa pointer to the socket address
+ *  \param len pointer to the length of the socket address
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if the address is not valid or can not be resolved
+ */
+static int tpResolve (const char *addr, bool passive, struct sockaddr_storage *sa, socklen_t *len)
+{
+    memset (sa, 0, sizeof (*sa));
+    if (strncmp (addr, "unix:", 5) == 0) {
+        struct sockaddr_un *un = (struct sockaddr_un *) sa;
+
+        if ((addr[5] == '\0') || (strlen (addr + 5) >= sizeof (un->sun_path))) {
+            errno = EINVAL;
+            return -1;
+        }
+        un->sun_family = AF_UNIX;
+        strcpy (un->sun_path, addr + 5);
+        *len = sizeof (*un);
+        return 0;
+    }
+    if (strncmp (addr, "tcp:", 4) == 0) {
+        char host[256];
+        const char *port = strrchr (addr + 4, ':');
+        struct addrinfo hints, *res;
+
+        if ((port == NULL) || (port[1] == '\0') || ((size_t) (port - addr - 4) >= sizeof (host))) {
+            errno = EINVAL;
+            return -1;
+        }
+        memcpy (host, addr + 4, port - addr - 4);
+        host[port - addr - 4] = '\0';
+        memset (&hints, 0, sizeof (hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = passive ? AI_PASSIVE : 0;
+        if (getaddrinfo ((host[0] != '\0') ? host : NULL, port + 1, &hints, &res) != 0) {
+            errno = EADDRNOTAVAIL;
+            return -1;
+        }
+        memcpy (sa, res->ai_addr, res->ai_addrlen);
+        *len = res->ai_addrlen;
+        freeaddrinfo (res);
+        return 0;
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+/**
+ *  \brief Initialization of a channel over a connected socket.
+ *
+ *  Small frames of a TCP connection are sent at once.
+ *
+ *  \param ch pointer to the channel
+ *  \param fd connected socket
+ */
+static void tpInit (TP_CHAN *ch, int fd)
+{
+    int one = 1;
+    struct sockaddr_storage sa;
+    socklen_t len = sizeof (sa);
+
+    memset (ch, 0, sizeof (*ch));
+    ch->fd = fd;
+    if ((getsockname (fd, (struct sockaddr *) &sa, &len) == 0) && (sa.ss_family != AF_UNIX)) {
+        setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+    }
+}
+
+/**
+ *  \brief Reception of a given number of bytes.
+ *
+ *  \param fd socket
+ *  \param buf buffer
+ *  \param len number of bytes
+ *
+ *  \return number of bytes received (less than <tt>len</tt> only if the peer closed the connection)
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+static ssize_t recvAll (int fd, void *buf, size_t len)
+{
+    size_t got = 0;
+    ssize_t n;
+
+    while (got < len) {
+        if ((n = recv (fd, (char *) buf + got, len - got, MSG_WAITALL)) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        got += (size_t) n;
+    }
+    return (ssize_t) got;
+}
+
+/**
+ *  \brief Listening on an address.
+ *
+ *  A Unix-domain socket left behind by a previous run is removed.
+ *
+ *  \param addr address
+ *
+ *  \return listening socket, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int tpListen (const char *addr)
+{
+    struct sockaddr_storage sa;
+    socklen_t len;
+    struct stat st;
+    int fd, one = 1;
+
+    if (tpResolve (addr, true, &sa, &len) == -1) {
+        return -1;
+    }
+    if (sa.ss_family == AF_UNIX) {
+        const char *path = ((struct sockaddr_un *) &sa)->sun_path;
+
+        if ((stat (path, &st) == 0) && S_ISSOCK (st.st_mode)) {
+            unlink (path);
+        }
+    }
+    if ((fd = socket (sa.ss_family, SOCK_STREAM, 0)) == -1) {
+        return -1;
+    }
+    if (sa.ss_family != AF_UNIX) {
+        setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof (one));
+    }
+    if ((bind (fd, (struct sockaddr *) &sa, len) == -1) || (listen (fd, SOMAXCONN) == -1)) {
+        int err = errno;
+
+        close (fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ *  \brief Acceptance of a connection.
+ *
+ *  \param lfd listening socket
+ *  \param ch pointer to the channel of the connection
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int tpAccept (int lfd, TP_CHAN *ch)
+{
+    int fd;
+
+    while ((fd = accept (lfd, NULL, NULL)) == -1) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    tpInit (ch, fd);
+    return 0;
+}
+
+/**
+ *  \brief Connection to an address.
+ *
+ *  The connection is retried while nobody listens on the address, up to a timeout.
+ *
+ *  \param addr address
+ *  \param timeoutMs timeout (ms)
+ *  \param ch pointer to the channel of the connection
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int tpConnect (const char *addr, unsigned int timeoutMs, TP_CHAN *ch)
+{
+    struct sockaddr_storage sa;
+    socklen_t len;
+    uint64_t deadline = nowNs () + timeoutMs * 1000000ull;
+    int fd, err;
+
+    if (tpResolve (addr, false, &sa, &len) == -1) {
+        return -1;
+    }
+    for (;;) {
+        if ((fd = socket (sa.ss_family, SOCK_STREAM, 0)) == -1) {
+            return -1;
+        }
+        if (connect (fd, (struct sockaddr *) &sa, len) == 0) {
+            break;
+        }
+        err = errno;
+        close (fd);
+        if (((err != ECONNREFUSED) && (err != ENOENT)) || (nowNs () >= deadline)) {
+            errno = err;
+            return -1;
+        }
+        usleep (10000);                                                   /* the coordinator is not listening yet */
+    }
+    tpInit (ch, fd);
+    return 0;
+}
+
+/**
+ *  \brief Queueing of an event.
+ *
+ *  The queued events are sent when the batch is full or when the channel is flushed.
+ *
+ *  \param ch pointer to the channel
+ *  \param type type of the event
+ *  \param from sender of the event
+ *  \param order id of the order
+ *  \param arg argument of the event
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int tpQueue (TP_CHAN *ch, unsigned int type, unsigned int from, uint32_t order, uint64_t arg)
+{
+    TP_MSG *m;
+
+    if ((ch->nOut == TPBATCH) && (tpFlush (ch) == -1)) {
+        return -1;
+    }
+    m = &ch->out[ch->nOut++];
+    m->type  = htons ((uint16_t) type);
+    m->from  = htons ((uint16_t) from);
+    m->order = htonl (order);
+    m->arg   = htobe64 (arg);
+    return 0;
+}
+
+/**
+ *  \brief Sending of the queued events in a frame.
+ *
+ *  Nothing is sent if no event is queued.
+ *
+ *  \param ch pointer to the channel
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int tpFlush (TP_CHAN *ch)
+{
+    struct iovec iov[2];                                            /* length prefix and batch, gathered */
+    struct msghdr msg;
+    ssize_t n;
+
+    if (ch->nOut == 0) {
+        return 0;
+    }
+    ch->len = htonl ((uint32_t) (ch->nOut * sizeof (TP_MSG)));
+    iov[0].iov_base = &ch->len;
+    iov[0].iov_len  = sizeof (ch->len);
+    iov[1].iov_base = ch->out;
+    iov[1].iov_len  = ch->nOut * sizeof (TP_MSG);
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    while (msg.msg_iovlen > 0) {
+        if ((n = sendmsg (ch->fd, &msg, MSG_NOSIGNAL)) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        while ((msg.msg_iovlen > 0) && ((size_t) n >= msg.msg_iov->iov_len)) {       /* partial write */
+            n -= (ssize_t) msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0) {
+            msg.msg_iov->iov_base = (char *) msg.msg_iov->iov_base + n;
+            msg.msg_iov->iov_len -= (size_t) n;
+        }
+    }
+    ch->frames += 1;
+    ch->events += ch->nOut;
+    ch->nOut = 0;
+    return 0;
+}
+
+/**
+ *  \brief Reception of a frame.
+ *
+ *  The call blocks until a whole frame is received; its events are left in <tt>ch->in</tt>.
+ *
+ *  \param ch pointer to the channel
+ *
+ *  \return number of events, upon success
+ *  \return \c 0, if the peer closed the connection
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int tpRecv (TP_CHAN *ch)
+{
+    uint32_t len;
+    ssize_t n;
+    unsigned int i, nIn;
+
+    if ((n = recvAll (ch->fd, &len, sizeof (len))) <= 0) {
+        return (int) n;
+    }
+    len = ntohl (len);
+    if ((n < (ssize_t) sizeof (len)) || (len == 0) || (len % sizeof (TP_MSG) != 0) || (len > sizeof (ch->in))) {
+        errno = EPROTO;
+        return -1;
+    }
+    if ((n = recvAll (ch->fd, ch->in, len)) == -1) {
+        return -1;
+    }
+    if (n < (ssize_t) len) {                                                 /* connection closed within a frame */
+        errno = EPROTO;
+        return -1;
+    }
+    nIn = len / sizeof (TP_MSG);
+    for (i = 0; i < nIn; i++) {
+        ch->in[i].type  = ntohs (ch->in[i].type);
+        ch->in[i].from  = ntohs (ch->in[i].from);
+        ch->in[i].order = ntohl (ch->in[i].order);
+        ch->in[i].arg   = be64toh (ch->in[i].arg);
+    }
+    return (int) nIn;
+}
+
+/**
+ *  \brief Closing of a channel.
+ *
+ *  \param ch pointer to the channel
+ */
+void tpClose (TP_CHAN *ch)
+{
+    if (ch->fd >= 0) {
+        close (ch->fd);
+        ch->fd = -1;
+    }
+}
+
+/**
+ *  \brief Closing of a listening socket.
+ *
+ *  The path of a Unix-domain socket is removed.
+ *
+ *  \param lfd listening socket
+ *  \param addr address it listens on
+ */
+void tpUnlisten (int lfd, const char *addr)
+{
+    close (lfd);
+    if (strncmp (addr, "unix:", 5) == 0) {
+        unlink (addr + 5);
+    }
+}
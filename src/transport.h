@@ -0,0 +1,190 @@
+/**
+ *  \file transport.h (interface file)
+ *
+ *  \brief Socket transport of the protocol events between the coordinator and the entity nodes.
+ *
+ *  A channel is a stream connection (Unix-domain or TCP) that carries frames: a 32 bit length prefix followed by
+ *  a batch of fixed size events. Events are queued straight into the batch of the channel, in network byte
+ *  order, and a frame is sent with a single gather write of the prefix and the batch; a received frame is
+ *  read straight into the receive batch and its events are converted in place. No event is copied into an
+ *  intermediate buffer on either side.
+ *
+ *  Addresses are given as <tt>unix:path</tt> or <tt>tcp:host:port</tt> (an empty host listens on every interface).
+ *
+ *  Defined operations:
+ *     \li listening on an address
+ *     \li acceptance of a connection
+ *     \li connection to an address
+ *     \li queueing of an event
+ *     \li sending of the queued events in a frame
+ *     \li reception of a frame
+ *     \li closing of a channel and of a listening socket.
+ */
+
+#ifndef TRANSPORT_H_
+#define TRANSPORT_H_
+
+#include <stdint.h>
+
+/** \brief maximum number of events in a frame */
+#define  TPBATCH          64
+
+/* Protocol events (the sender of each one is given in the <tt>from</tt> field, as an ENT_* slot) */
+
+/** \brief node joins the factory (node -> coordinator) */
+#define  TP_HELLO         1
+/** \brief configuration of the node: <tt>order</tt> holds the time scale in millionths, <tt>arg</tt> the seed */
+#define  TP_WELCOME       2
+/** \brief agent may prepare the ingredients of an order (coordinator -> agent) */
+#define  TP_GO            3
+/** \brief ingredients of an order prepared, <tt>arg</tt> holds both (agent -> coordinator) */
+#define  TP_PREPARED      4
+/** \brief ingredient of an order available (coordinator -> watcher) */
+#define  TP_INGREDIENT    5
+/** \brief ingredient of an order reserved (watcher -> coordinator) */
+#define  TP_RESERVE       6
+/** \brief order handed to a smoker worker (coordinator -> smoker) */
+#define  TP_ORDER         7
+/** \brief smoker worker started rolling (smoker -> coordinator) */
+#define  TP_ROLLING       8
+/** \brief smoker worker completed the cigarette (smoker -> coordinator) */
+#define  TP_DONE          9
+/** \brief smoker worker finished smoking and waits again (smoker -> coordinator) */
+#define  TP_WAITING       10
+/** \brief factory is closing (coordinator -> node) */
+#define  TP_CLOSE         11
+/** \brief node leaves the factory (node -> coordinator) */
+#define  TP_BYE           12
+
+/**
+ *  \brief Definition of <em>protocol event</em> data type.
+ */
+typedef struct {
+    /** \brief type of the event (see TP_*) */
+    uint16_t type;
+    /** \brief sender of the event */
+    uint16_t from;
+    /** \brief id of the order */
+    uint32_t order;
+    /** \brief argument of the event */
+    uint64_t arg;
+
+} TP_MSG;
+
+/**
+ *  \brief Definition of <em>channel</em> data type.
+ */
+typedef struct {
+    /** \brief socket */
+    int fd;
+    /** \brief length prefix of the frame being sent */
+    uint32_t len;
+    /** \brief number of queued events */
+    unsigned int nOut;
+    /** \brief queued events */
+    TP_MSG out[TPBATCH];
+    /** \brief events of the last frame received */
+    TP_MSG in[TPBATCH];
+    /** \brief number of frames sent */
+    unsigned long long frames;
+    /** \brief number of events sent */
+    unsigned long long events;
+
+} TP_CHAN;
+
+/**
+ *  \brief Listening on an address.
+ *
+ *  A Unix-domain socket left behind by a previous run is removed.
+ *
+ *  \param addr address
+ *
+ *  \return listening socket, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int tpListen (const char *addr);
+
+/**
+ *  \brief Acceptance of a connection.
+ *
+ *  \param lfd listening socket
+ *  \param ch pointer to the channel of the connection
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int tpAccept (int lfd, TP_CHAN *ch);
+
+/**
+ *  \brief Connection to an address.
+ *
+ *  The connection is retried while nobody listens on the address, up to a timeout.
+ *
+ *  \param addr address
+ *  \param timeoutMs timeout (ms)
+ *  \param ch pointer to the channel of the connection
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int tpConnect (const char *addr, unsigned int timeoutMs, TP_CHAN *ch);
+
+/**
+ *  \brief Queueing of an event.
+ *
+ *  The queued events are sent when the batch is full or when the channel is flushed.
+ *
+ *  \param ch pointer to the channel
+ *  \param type type of the event
+ *  \param from sender of the event
+ *  \param order id of the order
+ *  \param arg argument of the event
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int tpQueue (TP_CHAN *ch, unsigned int type, unsigned int from, uint32_t order, uint64_t arg);
+
+/**
+ *  \brief Sending of the queued events in a frame.
+ *
+ *  Nothing is sent if no event is queued.
+ *
+ *  \param ch pointer to the channel
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int tpFlush (TP_CHAN *ch);
+
+/**
+ *  \brief Reception of a frame.
+ *
+ *  The call blocks until a whole frame is received; its events are left in <tt>ch->in</tt>.
+ *
+ *  \param ch pointer to the channel
+ *
+ *  \return number of events, upon success
+ *  \return \c 0, if the peer closed the connection
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int tpRecv (TP_CHAN *ch);
+
+/**
+ *  \brief Closing of a channel.
+ *
+ *  \param ch pointer to the channel
+ */
+extern void tpClose (TP_CHAN *ch);
+
+/**
+ *  \brief Closing of a listening socket.
+ *
+ *  The path of a Unix-domain socket is removed.
+ *
+ *  \param lfd listening socket
+ *  \param addr address it listens on
+ */
+extern void tpUnlisten (int lfd, const char *addr);
+
+#endif /* TRANSPORT_H_ */